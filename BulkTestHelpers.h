@@ -0,0 +1,26 @@
+﻿#pragma once
+
+#include "BulkTransform.h"
+#include "TransformIterator.h"
+
+#include <vector>
+
+/// <summary>
+/// Transforms a vector with transformCopy, which takes the block kernel of the operation when it has one.
+/// </summary>
+template <class Output, class Input, class Operation>
+std::vector<Output> bulk(const std::vector<Input>& input, Operation operation)
+{
+	std::vector<Output> out(input.size());
+	lagy::transformCopy(lagy::TransformIterator(input.begin(), operation), lagy::TransformIterator(input.end(), operation), out.begin());
+	return out;
+}
+
+/// <summary>
+/// Transforms a vector one element at a time through TransformIterator.
+/// </summary>
+template <class Input, class Operation>
+auto perElement(const std::vector<Input>& input, Operation operation)
+{
+	return std::vector(lagy::TransformIterator(input.begin(), operation), lagy::TransformIterator(input.end(), operation));
+}
\ No newline at end of file
@@ -0,0 +1,231 @@
+﻿#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "CpuDispatch.h"
+#include "TransformIterator.h"
+
+namespace lagy {
+
+	namespace Detail
+	{
+		template <class Iterator, class = std::void_t<>>
+		struct IsStandardContiguousIterator : std::false_type {};
+
+		template <class Iterator>
+		[[nodiscard]]
+		constexpr bool isStandardContiguousIterator()
+		{
+			using Value = typename std::iterator_traits<Iterator>::value_type;
+			if constexpr (!std::is_object_v<Value> || std::is_same_v<Value, bool>)
+			{
+				return false;
+			}
+			else
+			{
+				return std::is_same_v<Iterator, typename std::vector<Value>::iterator> ||
+					std::is_same_v<Iterator, typename std::vector<Value>::const_iterator> ||
+					std::is_same_v<Iterator, std::string::iterator> ||
+					std::is_same_v<Iterator, std::string::const_iterator>;
+			}
+		}
+
+		template <class Iterator>
+		struct IsStandardContiguousIterator<Iterator, std::void_t<typename std::iterator_traits<Iterator>::value_type>> :
+			std::bool_constant<isStandardContiguousIterator<Iterator>()> {};
+	}
+
+	/// <summary>
+	/// Whether an iterator refers to elements stored contiguously in memory, so a range of them can be handed
+	/// to block kernels as a pointer. True for pointers (including std::array and std::string_view iterators)
+	/// and for std::vector and std::string iterators. Specialize for other contiguous iterators.
+	/// </summary>
+	template <class Iterator>
+	struct IsContiguousIterator : std::bool_constant<std::is_pointer_v<Iterator> || Detail::IsStandardContiguousIterator<Iterator>::value> {};
+
+	template <class Iterator>
+	inline constexpr bool IsContiguousIterator_v = IsContiguousIterator<Iterator>::value;
+
+	namespace Detail
+	{
+		template <class UnaryOperation, class Input, class Output, class = std::void_t<>>
+		struct HasBlockKernel : std::false_type {};
+
+		template <class UnaryOperation, class Input, class Output>
+		struct HasBlockKernel<UnaryOperation, Input, Output, std::void_t<decltype(std::declval<const UnaryOperation&>().applyBlock(
+			std::declval<const Input*>(), std::declval<const Input*>(), std::declval<Output*>()))>> : std::true_type {};
+
+		template <class Iterator>
+		using IteratorValue_t = std::remove_cv_t<std::remove_reference_t<decltype(*std::declval<Iterator&>())>>;
+	}
+
+	/// <summary>
+	/// Whether a UnaryOperation provides a block kernel, applyBlock(const Input* first, const Input* last, Output* out),
+	/// that transforms a whole contiguous block of Input values to Output values at once.
+	/// </summary>
+	template <class UnaryOperation, class Input, class Output>
+	inline constexpr bool HasBlockKernel_v = Detail::HasBlockKernel<UnaryOperation, Input, Output>::value;
+
+	/// <summary>
+	/// Gets the address of the element a contiguous iterator refers to. The iterator must be dereferenceable.
+	/// </summary>
+	template <class Iterator>
+	[[nodiscard]]
+	auto toAddress(const Iterator& it)
+	{
+		if constexpr (std::is_pointer_v<Iterator>)
+		{
+			return it;
+		}
+		else
+		{
+			return std::addressof(*it);
+		}
+	}
+
+	/// <summary>
+	/// Writes the transformed values of a range of TransformIterators to out.
+	///
+	/// When the wrapped iterators and the output are contiguous and the transform has a block kernel for their
+	/// value types, the whole range is handed to the kernel as pointers so it can be vectorized. Otherwise each
+	/// element is transformed through operator*, as a loop over the range would.
+	/// </summary>
+	/// <param name="first"> The start of the range. </param>
+	/// <param name="last"> The end of the range. </param>
+	/// <param name="out"> The start of the output. </param>
+	/// <return> The end of the output. </return>
+	template <class Iterator, class UnaryOperation, class OutputIterator>
+	OutputIterator transformCopy(const TransformIterator<Iterator, UnaryOperation>& first, const TransformIterator<Iterator, UnaryOperation>& last, OutputIterator out)
+	{
+		if constexpr (IsContiguousIterator_v<Iterator> && IsContiguousIterator_v<OutputIterator>)
+		{
+			using Input = Detail::IteratorValue_t<Iterator>;
+			using Output = Detail::IteratorValue_t<OutputIterator>;
+			if constexpr (HasBlockKernel_v<UnaryOperation, Input, Output>)
+			{
+				const Iterator& begin = first.getWrappedIterator();
+				const auto count = last.getWrappedIterator() - begin;
+				if (count > 0)
+				{
+					const Input* input = toAddress(begin);
+					first.getTransform().applyBlock(input, input + count, toAddress(out));
+				}
+				return out + count;
+			}
+		}
+
+		for (auto it = first; it != last; ++it, ++out)
+		{
+			*out = *it;
+		}
+		return out;
+	}
+
+	/// <summary>
+	/// The output size in bytes from which transformCopyStreaming uses non-temporal stores by default.
+	/// Outputs this large do not fit in the last level cache, so caching them only evicts other data.
+	/// </summary>
+	inline constexpr std::size_t streamingThreshold = std::size_t(8) << 20;
+
+	namespace Detail
+	{
+		inline constexpr std::size_t cacheLineSize = 64;
+		inline constexpr std::size_t streamingChunkSize = 4096;
+
+#if LAGY_X86_DISPATCH
+		__attribute__((target("sse2")))
+		inline void streamCacheLines(const void* source, void* destination, std::size_t bytes)
+		{
+			const auto* from = static_cast<const __m128i*>(source);
+			auto* to = static_cast<__m128i*>(destination);
+			for (std::size_t i = 0; i < bytes / sizeof(__m128i); ++i)
+			{
+				_mm_stream_si128(to + i, _mm_load_si128(from + i));
+			}
+		}
+
+		__attribute__((target("sse2")))
+		inline void streamFence()
+		{
+			_mm_sfence();
+		}
+#endif
+	}
+
+	/// <summary>
+	/// Writes the transformed values of a range of TransformIterators to a contiguous output, like transformCopy,
+	/// bypassing the cache for large outputs.
+	///
+	/// When the output is at least threshold bytes, the elements before the first cache line boundary of the
+	/// output are written normally. The whole cache lines after it are transformed in chunks into a buffer that
+	/// stays in the L1 cache, then copied out with non-temporal stores, which need no read for ownership and do
+	/// not evict other data. A store fence orders them before the remaining elements are written normally.
+	/// Smaller outputs, outputs whose element size does not divide a cache line, outputs that are not contiguous,
+	/// ranges wrapping input iterators, which cannot be walked twice, and processors (or LAGY_FORCE_ISA levels)
+	/// without SSE2 are written by transformCopy.
+	/// </summary>
+	/// <param name="first"> The start of the range. </param>
+	/// <param name="last"> The end of the range. </param>
+	/// <param name="out"> The start of the output. </param>
+	/// <param name="threshold"> The output size in bytes from which non-temporal stores are used. </param>
+	/// <return> The end of the output. </return>
+	template <class Iterator, class UnaryOperation, class OutputIterator>
+	OutputIterator transformCopyStreaming(const TransformIterator<Iterator, UnaryOperation>& first, const TransformIterator<Iterator, UnaryOperation>& last,
+		OutputIterator out, std::size_t threshold = streamingThreshold)
+	{
+#if LAGY_X86_DISPATCH
+		if constexpr (IsContiguousIterator_v<OutputIterator>)
+		{
+			using Output = Detail::IteratorValue_t<OutputIterator>;
+			// the range is walked once to count it and again to transform it, so input iterators are copied normally
+			if constexpr (std::is_base_of_v<std::forward_iterator_tag, typename std::iterator_traits<Iterator>::iterator_category> &&
+				std::is_trivially_copyable_v<Output> && std::is_default_constructible_v<Output> && Detail::cacheLineSize % sizeof(Output) == 0)
+			{
+				Iterator it = first.getWrappedIterator();
+				const auto count = static_cast<std::size_t>(std::distance(it, last.getWrappedIterator()));
+				Output* const destination = count == 0 ? nullptr : toAddress(out);
+				const auto address = reinterpret_cast<std::uintptr_t>(destination);
+				if (count != 0 && count * sizeof(Output) >= threshold && address % sizeof(Output) == 0 && activeIsa() >= Isa::Sse2)
+				{
+					const UnaryOperation& transform = first.getTransform();
+					auto copyNext = [&it, &transform](std::size_t n, Output* to)
+					{
+						Iterator next = std::next(it, static_cast<std::ptrdiff_t>(n));
+						transformCopy(TransformIterator<Iterator, UnaryOperation>(it, transform), TransformIterator<Iterator, UnaryOperation>(next, transform), to);
+						it = next;
+					};
+
+					// peel up to the first cache line boundary, then stream whole cache lines
+					const std::size_t peel = std::min(count, (Detail::cacheLineSize - address % Detail::cacheLineSize) % Detail::cacheLineSize / sizeof(Output));
+					const std::size_t body = (count - peel) * sizeof(Output) / Detail::cacheLineSize * Detail::cacheLineSize / sizeof(Output);
+					copyNext(peel, destination);
+
+					constexpr std::size_t chunk = Detail::streamingChunkSize / sizeof(Output);
+					alignas(Detail::cacheLineSize) Output staging[chunk];
+					for (std::size_t done = 0; done < body; done += chunk)
+					{
+						const std::size_t n = std::min(chunk, body - done);
+						copyNext(n, staging);
+						Detail::streamCacheLines(staging, destination + peel + done, n * sizeof(Output));
+					}
+					Detail::streamFence();
+
+					copyNext(count - peel - body, destination + peel + body);
+					return out + static_cast<std::ptrdiff_t>(count);
+				}
+			}
+		}
+#else
+		static_cast<void>(threshold);
+#endif
+		return transformCopy(first, last, out);
+	}
+}
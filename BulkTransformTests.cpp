@@ -0,0 +1,122 @@
+﻿#include "catch2/catch.hpp"
+#include "BulkTransform.h"
+#include "BulkTestHelpers.h"
+#include "Conversions.h"
+#include "TransformIterator.h"
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <iterator>
+#include <list>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace
+{
+	std::vector<std::int32_t> sequence(std::size_t count)
+	{
+		std::vector<std::int32_t> values;
+		for (std::size_t i = 0; i < count; ++i)
+		{
+			values.push_back(static_cast<std::int32_t>(i * 2654435761u));
+		}
+		return values;
+	}
+}
+
+TEST_CASE("transformCopyStreaming matches transformCopy at every alignment", "[BulkTransform]")
+{
+	const auto negate = [](const auto& it) { return -*it; };
+	for (std::size_t count : { std::size_t(0), std::size_t(1), std::size_t(15), std::size_t(16), std::size_t(17), std::size_t(1000), std::size_t(5000) })
+	{
+		const std::vector<std::int32_t> values = sequence(count);
+		const std::vector<std::int32_t> expected = bulk<std::int32_t>(values, negate);
+
+		// the output starts at every offset within a cache line, with guards on both sides
+		for (std::size_t offset = 0; offset < 16; ++offset)
+		{
+			INFO("count " << count << ", offset " << offset);
+			std::vector<std::int32_t> buffer(count + 32, 7);
+			const auto end = lagy::transformCopyStreaming(lagy::TransformIterator(values.begin(), negate), lagy::TransformIterator(values.end(), negate),
+				buffer.begin() + static_cast<std::ptrdiff_t>(offset), 0);
+			REQUIRE(end - buffer.begin() == static_cast<std::ptrdiff_t>(offset + count));
+			REQUIRE(std::vector<std::int32_t>(buffer.begin() + static_cast<std::ptrdiff_t>(offset), end) == expected);
+			REQUIRE(std::all_of(buffer.begin(), buffer.begin() + static_cast<std::ptrdiff_t>(offset), [](std::int32_t value) { return value == 7; }));
+			REQUIRE(std::all_of(end, buffer.end(), [](std::int32_t value) { return value == 7; }));
+		}
+	}
+}
+
+TEST_CASE("transformCopyStreaming uses block kernels and any input iterator", "[BulkTransform]")
+{
+	const std::vector<std::int32_t> values = sequence(10000);
+
+	const lagy::ConvertTo<float> toFloat;
+	std::vector<float> floats(values.size());
+	lagy::transformCopyStreaming(lagy::TransformIterator(values.begin(), toFloat), lagy::TransformIterator(values.end(), toFloat), floats.begin(), 0);
+	REQUIRE(floats == bulk<float>(values, toFloat));
+
+	const std::list<std::int32_t> list(values.begin(), values.end());
+	const auto twice = [](const auto& it) { return static_cast<std::int64_t>(*it) * 2; };
+	std::vector<std::int64_t> out(list.size());
+	lagy::transformCopyStreaming(lagy::TransformIterator(list.begin(), twice), lagy::TransformIterator(list.end(), twice), out.data() + 0, 0);
+	REQUIRE(out == bulk<std::int64_t>(values, twice));
+}
+
+TEST_CASE("transformCopyStreaming falls back to transformCopy", "[BulkTransform]")
+{
+	const std::vector<std::int32_t> values = sequence(3000);
+
+	// below the threshold
+	const auto increment = [](const auto& it) { return *it + 1; };
+	std::vector<std::int32_t> small(values.size());
+	lagy::transformCopyStreaming(lagy::TransformIterator(values.begin(), increment), lagy::TransformIterator(values.end(), increment), small.begin());
+	REQUIRE(small == bulk<std::int32_t>(values, increment));
+
+	// the element size does not divide a cache line
+	using Triple = std::array<std::uint8_t, 3>;
+	const auto bytes = [](const auto& it) { return Triple{ static_cast<std::uint8_t>(*it), static_cast<std::uint8_t>(*it >> 8), static_cast<std::uint8_t>(*it >> 16) }; };
+	std::vector<Triple> triples(values.size());
+	lagy::transformCopyStreaming(lagy::TransformIterator(values.begin(), bytes), lagy::TransformIterator(values.end(), bytes), triples.begin(), 0);
+	REQUIRE(triples == bulk<Triple>(values, bytes));
+
+	// the output is not contiguous
+	std::list<std::int32_t> list(values.size());
+	lagy::transformCopyStreaming(lagy::TransformIterator(values.begin(), increment), lagy::TransformIterator(values.end(), increment), list.begin(), 0);
+	REQUIRE(std::vector<std::int32_t>(list.begin(), list.end()) == small);
+
+	// the range can only be walked once
+	std::ostringstream text;
+	for (std::int32_t value : values)
+	{
+		text << value << ' ';
+	}
+	std::istringstream stream(text.str());
+	std::vector<std::int32_t> streamed(values.size());
+	const auto end = lagy::transformCopyStreaming(lagy::TransformIterator(std::istream_iterator<std::int32_t>(stream), increment),
+		lagy::TransformIterator(std::istream_iterator<std::int32_t>(), increment), streamed.begin(), 0);
+	REQUIRE(end == streamed.end());
+	REQUIRE(streamed == small);
+}
+
+TEST_CASE("transformCopyStreaming against transformCopy", "[BulkTransform][!benchmark]")
+{
+	const auto negate = [](const auto& it) { return -*it; };
+	for (std::size_t bytes : { lagy::streamingThreshold / 16, lagy::streamingThreshold * 4 })
+	{
+		const std::vector<std::int32_t> values = sequence(bytes / sizeof(std::int32_t));
+		std::vector<std::int32_t> out(values.size());
+		const std::string size = std::to_string(bytes >> 10) + " KiB";
+
+		BENCHMARK("transformCopy, " + size)
+		{
+			return lagy::transformCopy(lagy::TransformIterator(values.begin(), negate), lagy::TransformIterator(values.end(), negate), out.begin());
+		};
+		BENCHMARK("transformCopyStreaming, " + size)
+		{
+			return lagy::transformCopyStreaming(lagy::TransformIterator(values.begin(), negate), lagy::TransformIterator(values.end(), negate), out.begin());
+		};
+	}
+}
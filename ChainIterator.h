@@ -0,0 +1,427 @@
+﻿#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <iterator>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+namespace lagy {
+
+	namespace Detail
+	{
+		template <class First, class... Rest>
+		struct ChainReference
+		{
+			using type = std::conditional_t<
+				std::conjunction_v<std::is_same<typename std::iterator_traits<First>::reference, typename std::iterator_traits<Rest>::reference>...>,
+				typename std::iterator_traits<First>::reference,
+				std::common_type_t<typename std::iterator_traits<First>::value_type, typename std::iterator_traits<Rest>::value_type...>>;
+		};
+
+		template <class... Iterators>
+		using ChainReference_t = typename ChainReference<Iterators...>::type;
+
+		/// <summary>
+		/// Calls function with the tuple element at a runtime index.
+		/// </summary>
+		template <std::size_t I = 0, class Tuple, class Function>
+		decltype(auto) visitTupleAt(Tuple& tuple, std::size_t index, Function&& function)
+		{
+			if constexpr (I + 1 == std::tuple_size_v<std::remove_const_t<Tuple>>)
+			{
+				return function(std::get<I>(tuple));
+			}
+			else
+			{
+				if (index == I)
+				{
+					return function(std::get<I>(tuple));
+				}
+				return visitTupleAt<I + 1>(tuple, index, std::forward<Function>(function));
+			}
+		}
+	}
+
+	template <class... Iterators>
+	class ChainIterator;
+
+	/// <summary>
+	/// Several random access ranges, possibly of different iterator types, viewed as one sequence by ChainIterator.
+	/// Keeps the offset of the first element of every range so positions can be located by binary search.
+	/// </summary>
+	template <class... Iterators>
+	class Chain
+	{
+	public:
+		static_assert(sizeof...(Iterators) > 0, "Chain must be provided at least one range.");
+		static_assert(std::conjunction_v<std::is_base_of<std::random_access_iterator_tag, typename std::iterator_traits<Iterators>::iterator_category>...>,
+			"Chain must be provided random access ranges.");
+
+		using difference_type = std::common_type_t<typename std::iterator_traits<Iterators>::difference_type...>;
+
+		/// <summary>
+		/// The number of chained ranges.
+		/// </summary>
+		static constexpr std::size_t segmentCount = sizeof...(Iterators);
+
+		/// <summary>
+		/// Constructor:
+		/// Chains ranges in order. Empty ranges are allowed and skipped during iteration.
+		/// </summary>
+		/// <param name="ranges"> The bounds of each range. The ranges must outlive the chain. </param>
+		explicit Chain(std::pair<Iterators, Iterators>... ranges) :
+			m_ranges(std::move(ranges)...)
+		{
+			std::size_t segment = 0;
+			difference_type offset = 0;
+			std::apply([&](const auto&... range) { ((m_offsets[segment++] = offset, offset += range.second - range.first), ...); }, m_ranges);
+			m_offsets[segmentCount] = offset;
+		}
+
+		/// <summary>
+		/// Gets the total number of elements.
+		/// </summary>
+		[[nodiscard]]
+		difference_type size() const
+		{
+			return m_offsets[segmentCount];
+		}
+
+		/// <summary>
+		/// Gets the position of the first element of a range. segmentOffset(segmentCount) is size().
+		/// </summary>
+		[[nodiscard]]
+		difference_type segmentOffset(std::size_t segment) const
+		{
+			return m_offsets[segment];
+		}
+
+		/// <summary>
+		/// Finds the range containing a position, skipping empty ranges. Positions at the end map to segmentCount.
+		/// </summary>
+		[[nodiscard]]
+		std::size_t findSegment(difference_type position) const
+		{
+			return static_cast<std::size_t>(std::upper_bound(m_offsets.begin(), m_offsets.end(), position) - m_offsets.begin()) - 1;
+		}
+
+		/// <summary>
+		/// Calls function(first, last) with the wrapped iterators bounding the positions [from, to) of one range.
+		/// </summary>
+		/// <param name="segment"> The range. </param>
+		/// <param name="from"> The first position, within the range. </param>
+		/// <param name="to"> The position past the last one, within the range. </param>
+		/// <param name="function"> Called with iterators of the range's own type. </param>
+		template <class Function>
+		decltype(auto) visitSegment(std::size_t segment, difference_type from, difference_type to, Function&& function) const
+		{
+			const difference_type offset = m_offsets[segment];
+			return Detail::visitTupleAt(m_ranges, segment, [&](const auto& range) -> decltype(auto)
+			{
+				return function(range.first + (from - offset), range.first + (to - offset));
+			});
+		}
+
+		/// <summary>
+		/// Gets an iterator at the first element.
+		/// </summary>
+		[[nodiscard]]
+		ChainIterator<Iterators...> begin() const
+		{
+			return ChainIterator<Iterators...>(*this, 0);
+		}
+
+		/// <summary>
+		/// Gets an iterator past the last element.
+		/// </summary>
+		[[nodiscard]]
+		ChainIterator<Iterators...> end() const
+		{
+			return ChainIterator<Iterators...>(*this, size());
+		}
+
+	private:
+		std::tuple<std::pair<Iterators, Iterators>...> m_ranges;
+		std::array<difference_type, segmentCount + 1> m_offsets{};
+	};
+
+	/// <summary>
+	/// Chains containers or other ranges with begin and end, in order.
+	/// </summary>
+	/// <param name="ranges"> The ranges. Must outlive the chain. </param>
+	template <class... Ranges>
+	[[nodiscard]]
+	Chain<decltype(std::begin(std::declval<Ranges&>()))...> chain(Ranges&... ranges)
+	{
+		return Chain<decltype(std::begin(std::declval<Ranges&>()))...>(std::make_pair(std::begin(ranges), std::end(ranges))...);
+	}
+
+	/// <summary>
+	/// A random access iterator over the elements of a Chain, usable as the wrapped iterator of a TransformIterator.
+	/// Moving within a range is O(1); moving further locates the range by binary search over the range offsets.
+	///
+	/// The reference type is the common reference of the chained ranges if they all agree,
+	/// and otherwise the common type of their values, returned by value.
+	/// </summary>
+	template <class... Iterators>
+	class ChainIterator
+	{
+	public:
+
+		// std::iterator_traits types
+		using reference = Detail::ChainReference_t<Iterators...>;
+		using value_type = std::remove_cv_t<std::remove_reference_t<reference>>;
+		using difference_type = typename Chain<Iterators...>::difference_type;
+		using pointer = std::remove_reference_t<reference>*;
+		using iterator_category = std::random_access_iterator_tag;
+
+		ChainIterator() = default;
+
+		/// <summary>
+		/// Constructor:
+		/// Creates an iterator at a position of a chain.
+		/// </summary>
+		/// <param name="chain"> The chain. Must outlive the iterator. </param>
+		/// <param name="position"> The position of the element this iterator refers to. </param>
+		ChainIterator(const Chain<Iterators...>& chain, difference_type position) :
+			m_chain(&chain),
+			m_position(position),
+			m_segment(chain.findSegment(position))
+		{
+		}
+
+		/// <summary>
+		/// Gets the chain this iterator moves over.
+		/// </summary>
+		[[nodiscard]]
+		const Chain<Iterators...>& chain() const
+		{
+			return *m_chain;
+		}
+
+		/// <summary>
+		/// Gets the position of the element this iterator refers to.
+		/// </summary>
+		[[nodiscard]]
+		difference_type position() const
+		{
+			return m_position;
+		}
+
+		/// <summary>
+		/// Gets the index of the range containing the current element.
+		/// </summary>
+		[[nodiscard]]
+		std::size_t segmentIndex() const
+		{
+			return m_segment;
+		}
+
+		/// <summary>
+		/// Gets the current element.
+		/// </summary>
+		[[nodiscard]]
+		reference operator*() const
+		{
+			return m_chain->visitSegment(m_segment, m_position, m_position, [](const auto& it, const auto&) -> reference { return *it; });
+		}
+
+		/// <summary>
+		/// Gets the element n steps forward from the current one.
+		/// </summary>
+		[[nodiscard]]
+		reference operator[](difference_type n) const
+		{
+			return *(*this + n);
+		}
+
+		/// <summary>
+		/// Moves the iterator forward.
+		/// </summary>
+		ChainIterator& operator++()
+		{
+			++m_position;
+			while (m_segment < Chain<Iterators...>::segmentCount && m_position >= m_chain->segmentOffset(m_segment + 1))
+			{
+				++m_segment;
+			}
+			return *this;
+		}
+
+		/// <summary>
+		/// Moves the iterator forward.
+		/// Returns an iterator at the original position.
+		/// </summary>
+		[[nodiscard]]
+		ChainIterator operator++(int)
+		{
+			ChainIterator out(*this);
+			++(*this);
+			return out;
+		}
+
+		/// <summary>
+		/// Moves the iterator backward.
+		/// </summary>
+		ChainIterator& operator--()
+		{
+			return *this -= 1;
+		}
+
+		/// <summary>
+		/// Moves the iterator backward.
+		/// Returns an iterator at the original position.
+		/// </summary>
+		[[nodiscard]]
+		ChainIterator operator--(int)
+		{
+			ChainIterator out(*this);
+			--(*this);
+			return out;
+		}
+
+		/// <summary>
+		/// Moves the iterator forward n steps.
+		/// </summary>
+		ChainIterator& operator+=(difference_type n)
+		{
+			m_position += n;
+			if (m_segment >= Chain<Iterators...>::segmentCount || m_position < m_chain->segmentOffset(m_segment) || m_position >= m_chain->segmentOffset(m_segment + 1))
+			{
+				m_segment = m_chain->findSegment(m_position);
+			}
+			return *this;
+		}
+
+		/// <summary>
+		/// Moves the iterator backward n steps.
+		/// </summary>
+		ChainIterator& operator-=(difference_type n)
+		{
+			return *this += -n;
+		}
+
+		/// <summary>
+		/// Returns a new iterator n steps forward from this one.
+		/// </summary>
+		[[nodiscard]]
+		ChainIterator operator+(difference_type n) const
+		{
+			ChainIterator out(*this);
+			out += n;
+			return out;
+		}
+
+		/// <summary>
+		/// Returns a new iterator lhs steps forward from rhs.
+		/// </summary>
+		[[nodiscard]]
+		friend ChainIterator operator+(difference_type lhs, const ChainIterator& rhs)
+		{
+			return rhs + lhs;
+		}
+
+		/// <summary>
+		/// Returns a new iterator n steps backward from this one.
+		/// </summary>
+		[[nodiscard]]
+		ChainIterator operator-(difference_type n) const
+		{
+			ChainIterator out(*this);
+			out -= n;
+			return out;
+		}
+
+		/// <summary>
+		/// Returns the number of steps from rhs to lhs.
+		/// </summary>
+		[[nodiscard]]
+		friend difference_type operator-(const ChainIterator& lhs, const ChainIterator& rhs)
+		{
+			return lhs.m_position - rhs.m_position;
+		}
+
+		/// <summary>
+		/// Compare iterators for equality of position.
+		/// </summary>
+		[[nodiscard]]
+		friend bool operator==(const ChainIterator& lhs, const ChainIterator& rhs)
+		{
+			return lhs.m_position == rhs.m_position;
+		}
+
+		/// <summary>
+		/// Compare iterators for inequality of position.
+		/// </summary>
+		[[nodiscard]]
+		friend bool operator!=(const ChainIterator& lhs, const ChainIterator& rhs)
+		{
+			return lhs.m_position != rhs.m_position;
+		}
+
+		/// <summary>
+		/// Orders iterators by position.
+		/// </summary>
+		[[nodiscard]]
+		friend bool operator<(const ChainIterator& lhs, const ChainIterator& rhs)
+		{
+			return lhs.m_position < rhs.m_position;
+		}
+
+		/// <summary>
+		/// Orders iterators by position.
+		/// </summary>
+		[[nodiscard]]
+		friend bool operator>(const ChainIterator& lhs, const ChainIterator& rhs)
+		{
+			return rhs < lhs;
+		}
+
+		/// <summary>
+		/// Orders iterators by position.
+		/// </summary>
+		[[nodiscard]]
+		friend bool operator<=(const ChainIterator& lhs, const ChainIterator& rhs)
+		{
+			return !(rhs < lhs);
+		}
+
+		/// <summary>
+		/// Orders iterators by position.
+		/// </summary>
+		[[nodiscard]]
+		friend bool operator>=(const ChainIterator& lhs, const ChainIterator& rhs)
+		{
+			return !(lhs < rhs);
+		}
+
+	private:
+		const Chain<Iterators...>* m_chain = nullptr;
+		difference_type m_position = 0;
+		std::size_t m_segment = 0;
+	};
+
+	/// <summary>
+	/// Calls consumer(first, last) once per chained range overlapping [first, last), with iterators of that range's
+	/// own type, so algorithms can run a tight loop over each range instead of checking for range ends every step.
+	/// Empty ranges are skipped.
+	/// </summary>
+	/// <param name="first"> The start of the range. </param>
+	/// <param name="last"> The end of the range. </param>
+	/// <param name="consumer"> A generic callable accepting the iterator pair of any of the chained ranges. </param>
+	template <class... Iterators, class SegmentConsumer>
+	void forEachSegment(const ChainIterator<Iterators...>& first, const ChainIterator<Iterators...>& last, SegmentConsumer&& consumer)
+	{
+		const Chain<Iterators...>& chain = first.chain();
+		for (auto position = first.position(); position < last.position();)
+		{
+			const std::size_t segment = chain.findSegment(position);
+			const auto to = std::min(last.position(), chain.segmentOffset(segment + 1));
+			chain.visitSegment(segment, position, to, consumer);
+			position = to;
+		}
+	}
+}
@@ -0,0 +1,72 @@
+﻿#include "catch2/catch.hpp"
+#include "ChainIterator.h"
+#include "TransformIterator.h"
+
+#include <algorithm>
+#include <array>
+#include <deque>
+#include <vector>
+
+TEST_CASE("ChainIterator walks heterogeneous ranges as one sequence", "[ChainIterator]")
+{
+	std::vector<int> hot{ 1, 2, 3 };
+	std::vector<int> empty;
+	std::deque<int> cold{ 4, 5 };
+	std::array<int, 3> archived{ 6, 7, 8 };
+
+	auto chained = lagy::chain(hot, empty, cold, archived);
+	REQUIRE(chained.size() == 8);
+	static_assert(std::is_same_v<decltype(chained)::difference_type, std::ptrdiff_t>);
+	static_assert(std::is_same_v<lagy::ChainIterator<std::vector<int>::iterator, std::deque<int>::iterator>::reference, int&>);
+
+	std::vector<int> forward(chained.begin(), chained.end());
+	REQUIRE(forward == std::vector<int>{ 1, 2, 3, 4, 5, 6, 7, 8 });
+
+	std::vector<int> backward;
+	for (auto it = chained.end(); it != chained.begin();)
+	{
+		backward.push_back(*--it);
+	}
+	REQUIRE(backward == std::vector<int>{ 8, 7, 6, 5, 4, 3, 2, 1 });
+
+	// random access locates the range by binary search
+	auto it = chained.begin() + 3;
+	REQUIRE(*it == 4);
+	REQUIRE(it.segmentIndex() == 2);
+	REQUIRE(it[4] == 8);
+	REQUIRE((it += 3).segmentIndex() == 3);
+	REQUIRE(chained.end() - it == 2);
+	REQUIRE(std::binary_search(chained.begin(), chained.end(), 7));
+
+	// references reach the underlying ranges
+	*(chained.begin() + 4) = 50;
+	REQUIRE(cold[1] == 50);
+}
+
+TEST_CASE("ChainIterator composes with TransformIterator and forEachSegment", "[ChainIterator]")
+{
+	std::vector<int> hot{ 1, 2, 3 };
+	std::vector<long long> cold{ 10, 20 };
+	auto chained = lagy::chain(hot, cold);
+	static_assert(std::is_same_v<decltype(chained.begin())::reference, long long>);
+
+	auto twice = [](const auto& it) { return *it * 2; };
+	lagy::TransformIterator begin(chained.begin(), twice);
+	lagy::TransformIterator end(chained.end(), twice);
+	REQUIRE(std::vector<long long>(begin, end) == std::vector<long long>{ 2, 4, 6, 20, 40 });
+	REQUIRE(*(begin + 3) == 20);
+
+	// one tight loop per range, each with its own iterator type
+	std::vector<std::ptrdiff_t> segmentSizes;
+	long long sum = 0;
+	lagy::forEachSegment(chained.begin() + 1, chained.end() - 1, [&](auto first, auto last)
+	{
+		segmentSizes.push_back(last - first);
+		for (; first != last; ++first)
+		{
+			sum += *first;
+		}
+	});
+	REQUIRE(segmentSizes == std::vector<std::ptrdiff_t>{ 2, 1 });
+	REQUIRE(sum == 15);
+}
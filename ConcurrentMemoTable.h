@@ -0,0 +1,258 @@
+﻿#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <thread>
+#include <type_traits>
+#include <utility>
+
+namespace lagy {
+
+	/// <summary>
+	/// A lock-free table of results indexed by position, shared between threads.
+	///
+	/// Every slot holds an atomic state (empty, computing, ready). The first thread to ask for a position claims
+	/// it and computes the value; threads asking for the same position meanwhile wait for that result instead of
+	/// computing it again. Slots are grouped in segments allocated on first use and freed only with the table, and
+	/// at most maxSegments are ever allocated; positions in segments beyond the bound are computed without being stored.
+	/// </summary>
+	template <class Value, std::size_t SegmentSize = 4096>
+	class ConcurrentMemoTable
+	{
+	public:
+		static_assert(SegmentSize > 0, "ConcurrentMemoTable segments must hold at least one slot.");
+
+		/// <summary>
+		/// Constructor:
+		/// Creates an empty table.
+		/// </summary>
+		/// <param name="size"> The number of positions. </param>
+		/// <param name="maxSegments"> The maximum number of segments ever allocated. Segments are never freed, so the table holds at most maxSegments * SegmentSize slots for its lifetime. </param>
+		explicit ConcurrentMemoTable(std::size_t size, std::size_t maxSegments = SIZE_MAX) :
+			m_size(size),
+			m_segmentCount((size + SegmentSize - 1) / SegmentSize),
+			m_maxSegments(maxSegments),
+			m_segments(std::make_unique<std::atomic<Segment*>[]>(m_segmentCount))
+		{
+			for (std::size_t i = 0; i < m_segmentCount; ++i)
+			{
+				m_segments[i].store(nullptr, std::memory_order_relaxed);
+			}
+		}
+
+		ConcurrentMemoTable(const ConcurrentMemoTable&) = delete;
+		ConcurrentMemoTable& operator=(const ConcurrentMemoTable&) = delete;
+
+		~ConcurrentMemoTable()
+		{
+			for (std::size_t i = 0; i < m_segmentCount; ++i)
+			{
+				delete m_segments[i].load(std::memory_order_relaxed);
+			}
+		}
+
+		/// <summary>
+		/// Gets the number of positions.
+		/// </summary>
+		[[nodiscard]]
+		std::size_t size() const
+		{
+			return m_size;
+		}
+
+		/// <summary>
+		/// Gets the number of segments allocated so far.
+		/// </summary>
+		[[nodiscard]]
+		std::size_t allocatedSegments() const
+		{
+			return m_allocated.load(std::memory_order_relaxed);
+		}
+
+		/// <summary>
+		/// Gets the value at a position, computing it if no thread has yet.
+		/// If compute throws, the position is released so a later call can retry.
+		/// </summary>
+		/// <param name="position"> A position in [0, size). </param>
+		/// <param name="compute"> Called without arguments to compute the value. </param>
+		/// <return> The value at the position. </return>
+		template <class Compute>
+		Value getOrCompute(std::size_t position, Compute&& compute)
+		{
+			Segment* segment = acquireSegment(position / SegmentSize);
+			if (segment == nullptr)
+			{
+				return std::invoke(std::forward<Compute>(compute));
+			}
+
+			Slot& slot = segment->slots[position % SegmentSize];
+			std::uint8_t state = slot.state.load(std::memory_order_acquire);
+			if (state == Ready)
+			{
+				return slot.value();
+			}
+
+			if (state == Empty && slot.state.compare_exchange_strong(state, Computing, std::memory_order_acquire))
+			{
+				try
+				{
+					::new (static_cast<void*>(slot.storage)) Value(std::invoke(std::forward<Compute>(compute)));
+				}
+				catch (...)
+				{
+					slot.state.store(Empty, std::memory_order_release);
+					throw;
+				}
+				slot.state.store(Ready, std::memory_order_release);
+				return slot.value();
+			}
+
+			// another thread is computing the value: wait for it, or take over if it failed
+			for (unsigned spins = 0;; ++spins)
+			{
+				state = slot.state.load(std::memory_order_acquire);
+				if (state == Ready)
+				{
+					return slot.value();
+				}
+				if (state == Empty)
+				{
+					return getOrCompute(position, std::forward<Compute>(compute));
+				}
+				if (spins > 64)
+				{
+					std::this_thread::yield();
+				}
+			}
+		}
+
+	private:
+
+		enum : std::uint8_t
+		{
+			Empty,
+			Computing,
+			Ready
+		};
+
+		struct Slot
+		{
+			std::atomic<std::uint8_t> state{ Empty };
+			alignas(Value) unsigned char storage[sizeof(Value)];
+
+			[[nodiscard]]
+			const Value& value() const
+			{
+				return *std::launder(reinterpret_cast<const Value*>(storage));
+			}
+		};
+
+		struct Segment
+		{
+			Slot slots[SegmentSize];
+
+			~Segment()
+			{
+				for (Slot& slot : slots)
+				{
+					if (slot.state.load(std::memory_order_relaxed) == Ready)
+					{
+						std::launder(reinterpret_cast<Value*>(slot.storage))->~Value();
+					}
+				}
+			}
+		};
+
+		[[nodiscard]]
+		Segment* acquireSegment(std::size_t index)
+		{
+			Segment* segment = m_segments[index].load(std::memory_order_acquire);
+			if (segment != nullptr)
+			{
+				return segment;
+			}
+
+			// reserve room under the bound before allocating
+			std::size_t allocated = m_allocated.load(std::memory_order_relaxed);
+			do
+			{
+				if (allocated >= m_maxSegments)
+				{
+					return nullptr;
+				}
+			} while (!m_allocated.compare_exchange_weak(allocated, allocated + 1, std::memory_order_relaxed));
+
+			auto created = std::make_unique<Segment>();
+			if (m_segments[index].compare_exchange_strong(segment, created.get(), std::memory_order_acq_rel))
+			{
+				return created.release();
+			}
+
+			// another thread installed the segment first
+			m_allocated.fetch_sub(1, std::memory_order_relaxed);
+			return segment;
+		}
+
+		const std::size_t m_size;
+		const std::size_t m_segmentCount;
+		const std::size_t m_maxSegments;
+		std::unique_ptr<std::atomic<Segment*>[]> m_segments;
+		std::atomic<std::size_t> m_allocated{ 0 };
+	};
+
+	/// <summary>
+	/// A UnaryOperation for TransformIterator that looks up the result of an expensive pure operation in a
+	/// ConcurrentMemoTable shared by every copy, indexed by the distance of the wrapped iterator from the start
+	/// of the range. Threads scanning overlapping parts of a random access range compute each position once.
+	/// </summary>
+	template <class Iterator, class UnaryOperation, std::size_t SegmentSize = 4096>
+	class SharedMemoTransform
+	{
+	public:
+		using result_type = std::decay_t<std::invoke_result_t<const UnaryOperation&, const Iterator&>>;
+		using Table = ConcurrentMemoTable<result_type, SegmentSize>;
+
+		/// <summary>
+		/// Constructor:
+		/// Creates a table covering [first, last).
+		/// </summary>
+		/// <param name="first"> The start of the range positions are measured from. </param>
+		/// <param name="last"> The end of the range. </param>
+		/// <param name="operation"> A pure operation. </param>
+		/// <param name="maxSegments"> The maximum number of table segments ever allocated. Segments are never freed, so the table holds at most maxSegments * SegmentSize slots for its lifetime. </param>
+		SharedMemoTransform(Iterator first, Iterator last, UnaryOperation operation, std::size_t maxSegments = SIZE_MAX) :
+			m_first(first),
+			m_operation(std::move(operation)),
+			m_table(std::make_shared<Table>(static_cast<std::size_t>(last - first), maxSegments))
+		{
+		}
+
+		/// <summary>
+		/// Gets the result at the iterator's position, computing it once across all threads.
+		/// </summary>
+		[[nodiscard]]
+		result_type operator()(const Iterator& it) const
+		{
+			return m_table->getOrCompute(static_cast<std::size_t>(it - m_first), [this, &it]() { return std::invoke(m_operation, it); });
+		}
+
+		/// <summary>
+		/// Gets the shared table.
+		/// </summary>
+		[[nodiscard]]
+		const Table& table() const
+		{
+			return *m_table;
+		}
+
+	private:
+		Iterator m_first;
+		UnaryOperation m_operation;
+		std::shared_ptr<Table> m_table;
+	};
+}
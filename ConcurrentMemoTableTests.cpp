@@ -0,0 +1,83 @@
+﻿#include "catch2/catch.hpp"
+#include "ConcurrentMemoTable.h"
+#include "TransformIterator.h"
+
+#include <atomic>
+#include <numeric>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+TEST_CASE("ConcurrentMemoTable computes each position once across threads", "[ConcurrentMemoTable]")
+{
+	std::vector<int> values(5000);
+	std::iota(values.begin(), values.end(), 0);
+
+	std::atomic<int> computations = 0;
+	auto expensive = [&computations](const std::vector<int>::const_iterator& it)
+	{
+		++computations;
+		return static_cast<long long>(*it) * *it;
+	};
+
+	lagy::SharedMemoTransform<std::vector<int>::const_iterator, decltype(expensive), 256> transform(values.cbegin(), values.cend(), expensive);
+
+	// overlapping scans: every thread reads the whole range
+	std::vector<long long> sums(4);
+	std::vector<std::thread> threads;
+	for (std::size_t t = 0; t < sums.size(); ++t)
+	{
+		threads.emplace_back([&, t]()
+		{
+			lagy::TransformIterator begin(values.cbegin(), transform);
+			lagy::TransformIterator end(values.cend(), transform);
+			sums[t] = std::accumulate(begin, end, 0ll);
+		});
+	}
+	for (std::thread& thread : threads)
+	{
+		thread.join();
+	}
+
+	long long expected = 0;
+	for (int value : values)
+	{
+		expected += static_cast<long long>(value) * value;
+	}
+	for (long long sum : sums)
+	{
+		REQUIRE(sum == expected);
+	}
+	REQUIRE(computations == 5000);
+	REQUIRE(transform.table().allocatedSegments() == 20);
+}
+
+TEST_CASE("ConcurrentMemoTable bounds its segments and retries failed computations", "[ConcurrentMemoTable]")
+{
+	lagy::ConcurrentMemoTable<int, 16> table(64, 2);
+	REQUIRE(table.size() == 64);
+	REQUIRE(table.allocatedSegments() == 0);
+
+	int computations = 0;
+	auto lookup = [&](std::size_t position) { return table.getOrCompute(position, [&]() { ++computations; return static_cast<int>(position) * 3; }); };
+
+	// segments are allocated lazily, up to the bound
+	REQUIRE(lookup(40) == 120);
+	REQUIRE(lookup(40) == 120);
+	REQUIRE(table.allocatedSegments() == 1);
+	REQUIRE(lookup(1) == 3);
+	REQUIRE(table.allocatedSegments() == 2);
+	REQUIRE(computations == 2);
+
+	// positions beyond the bound are computed every time
+	REQUIRE(lookup(20) == 60);
+	REQUIRE(lookup(20) == 60);
+	REQUIRE(table.allocatedSegments() == 2);
+	REQUIRE(computations == 4);
+
+	// a throwing computation leaves the position free for a retry
+	REQUIRE_THROWS_AS(table.getOrCompute(2, []() -> int { throw std::runtime_error("failed"); }), std::runtime_error);
+	REQUIRE(lookup(2) == 6);
+	REQUIRE(lookup(2) == 6);
+	REQUIRE(computations == 5);
+}
@@ -0,0 +1,598 @@
+﻿#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <type_traits>
+
+#include "BulkTransform.h"
+#include "CpuDispatch.h"
+
+namespace lagy {
+
+	namespace Detail
+	{
+		template <class T>
+		[[nodiscard]]
+		T swapBytes(T value)
+		{
+			using Unsigned = std::make_unsigned_t<T>;
+#if defined(__GNUC__) || defined(__clang__)
+			if constexpr (sizeof(T) == 2)
+			{
+				return static_cast<T>(__builtin_bswap16(static_cast<Unsigned>(value)));
+			}
+			else if constexpr (sizeof(T) == 4)
+			{
+				return static_cast<T>(__builtin_bswap32(static_cast<Unsigned>(value)));
+			}
+			else
+			{
+				return static_cast<T>(__builtin_bswap64(static_cast<Unsigned>(value)));
+			}
+#else
+			auto bits = static_cast<Unsigned>(value);
+			Unsigned swapped = 0;
+			for (std::size_t byte = 0; byte < sizeof(T); ++byte, bits >>= 8)
+			{
+				swapped = static_cast<Unsigned>((swapped << 8) | (bits & 0xFF));
+			}
+			return static_cast<T>(swapped);
+#endif
+		}
+
+		template <class T>
+		void byteSwapScalar(const T* first, const T* last, T* out)
+		{
+			for (; first != last; ++first, ++out)
+			{
+				*out = swapBytes(*first);
+			}
+		}
+
+		[[nodiscard]]
+		std::uint16_t floatToHalf(float value);
+
+		template <class To, class From>
+		[[nodiscard]]
+		To saturate(From value);
+
+		template <class From, class To>
+		void convertScalar(const From* first, const From* last, To* out)
+		{
+			for (; first != last; ++first, ++out)
+			{
+				*out = static_cast<To>(*first);
+			}
+		}
+
+		inline void floatToHalfScalar(const float* first, const float* last, std::uint16_t* out)
+		{
+			for (; first != last; ++first, ++out)
+			{
+				*out = floatToHalf(*first);
+			}
+		}
+
+		template <class From, class To>
+		void saturateScalar(const From* first, const From* last, To* out)
+		{
+			for (; first != last; ++first, ++out)
+			{
+				*out = saturate<To>(*first);
+			}
+		}
+
+#if LAGY_X86_DISPATCH
+		template <class T>
+		[[nodiscard]]
+		const std::uint8_t* byteSwapShuffle()
+		{
+			// byte k of each lane takes byte (size - 1 - k) of the same element
+			alignas(16) static const std::array<std::uint8_t, 16> shuffle = []()
+			{
+				std::array<std::uint8_t, 16> out{};
+				for (std::size_t k = 0; k < 16; ++k)
+				{
+					out[k] = static_cast<std::uint8_t>(k - k % sizeof(T) + sizeof(T) - 1 - k % sizeof(T));
+				}
+				return out;
+			}();
+			return shuffle.data();
+		}
+
+		template <class T>
+		__attribute__((target("ssse3")))
+		void byteSwapSse41(const T* first, const T* last, T* out)
+		{
+			const __m128i mask = _mm_load_si128(reinterpret_cast<const __m128i*>(byteSwapShuffle<T>()));
+			for (constexpr std::ptrdiff_t step = 16 / sizeof(T); last - first >= step; first += step, out += step)
+			{
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(out), _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(first)), mask));
+			}
+			byteSwapScalar(first, last, out);
+		}
+
+		template <class T>
+		__attribute__((target("avx2")))
+		void byteSwapAvx2(const T* first, const T* last, T* out)
+		{
+			const __m256i mask = _mm256_broadcastsi128_si256(_mm_load_si128(reinterpret_cast<const __m128i*>(byteSwapShuffle<T>())));
+			for (constexpr std::ptrdiff_t step = 32 / sizeof(T); last - first >= step; first += step, out += step)
+			{
+				_mm256_storeu_si256(reinterpret_cast<__m256i*>(out), _mm256_shuffle_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(first)), mask));
+			}
+			byteSwapScalar(first, last, out);
+		}
+
+		template <class T>
+		__attribute__((target("avx512f,avx512bw")))
+		void byteSwapAvx512(const T* first, const T* last, T* out)
+		{
+			const __m512i mask = _mm512_broadcast_i32x4(_mm_load_si128(reinterpret_cast<const __m128i*>(byteSwapShuffle<T>())));
+			for (constexpr std::ptrdiff_t step = 64 / sizeof(T); last - first >= step; first += step, out += step)
+			{
+				_mm512_storeu_si512(out, _mm512_shuffle_epi8(_mm512_loadu_si512(first), mask));
+			}
+			byteSwapScalar(first, last, out);
+		}
+
+		__attribute__((target("sse2")))
+		inline void int32ToFloatSse41(const std::int32_t* first, const std::int32_t* last, float* out)
+		{
+			for (; last - first >= 4; first += 4, out += 4)
+			{
+				_mm_storeu_ps(out, _mm_cvtepi32_ps(_mm_loadu_si128(reinterpret_cast<const __m128i*>(first))));
+			}
+			convertScalar(first, last, out);
+		}
+
+		__attribute__((target("avx2")))
+		inline void int32ToFloatAvx2(const std::int32_t* first, const std::int32_t* last, float* out)
+		{
+			for (; last - first >= 8; first += 8, out += 8)
+			{
+				_mm256_storeu_ps(out, _mm256_cvtepi32_ps(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(first))));
+			}
+			convertScalar(first, last, out);
+		}
+
+		__attribute__((target("avx512f")))
+		inline void int32ToFloatAvx512(const std::int32_t* first, const std::int32_t* last, float* out)
+		{
+			for (; last - first >= 16; first += 16, out += 16)
+			{
+				_mm512_storeu_ps(out, _mm512_cvtepi32_ps(_mm512_loadu_si512(first)));
+			}
+			convertScalar(first, last, out);
+		}
+
+		__attribute__((target("avx2,f16c")))
+		inline void floatToHalfAvx2(const float* first, const float* last, std::uint16_t* out)
+		{
+			for (; last - first >= 8; first += 8, out += 8)
+			{
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(out), _mm256_cvtps_ph(_mm256_loadu_ps(first), _MM_FROUND_TO_NEAREST_INT));
+			}
+			floatToHalfScalar(first, last, out);
+		}
+
+		__attribute__((target("avx512f")))
+		inline void floatToHalfAvx512(const float* first, const float* last, std::uint16_t* out)
+		{
+			for (; last - first >= 16; first += 16, out += 16)
+			{
+				_mm256_storeu_si256(reinterpret_cast<__m256i*>(out), _mm512_cvtps_ph(_mm512_loadu_ps(first), _MM_FROUND_TO_NEAREST_INT));
+			}
+			floatToHalfScalar(first, last, out);
+		}
+
+		__attribute__((target("sse2")))
+		inline void int32ToInt16Sse41(const std::int32_t* first, const std::int32_t* last, std::int16_t* out)
+		{
+			for (; last - first >= 8; first += 8, out += 8)
+			{
+				const __m128i low = _mm_loadu_si128(reinterpret_cast<const __m128i*>(first));
+				const __m128i high = _mm_loadu_si128(reinterpret_cast<const __m128i*>(first + 4));
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(out), _mm_packs_epi32(low, high));
+			}
+			saturateScalar(first, last, out);
+		}
+
+		__attribute__((target("sse4.1")))
+		inline void int32ToUint16Sse41(const std::int32_t* first, const std::int32_t* last, std::uint16_t* out)
+		{
+			for (; last - first >= 8; first += 8, out += 8)
+			{
+				const __m128i low = _mm_loadu_si128(reinterpret_cast<const __m128i*>(first));
+				const __m128i high = _mm_loadu_si128(reinterpret_cast<const __m128i*>(first + 4));
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(out), _mm_packus_epi32(low, high));
+			}
+			saturateScalar(first, last, out);
+		}
+
+		template <class To>
+		__attribute__((target("sse2")))
+		void int16ToByteSse41(const std::int16_t* first, const std::int16_t* last, To* out)
+		{
+			for (; last - first >= 16; first += 16, out += 16)
+			{
+				const __m128i low = _mm_loadu_si128(reinterpret_cast<const __m128i*>(first));
+				const __m128i high = _mm_loadu_si128(reinterpret_cast<const __m128i*>(first + 8));
+				const __m128i packed = std::is_signed_v<To> ? _mm_packs_epi16(low, high) : _mm_packus_epi16(low, high);
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(out), packed);
+			}
+			saturateScalar(first, last, out);
+		}
+
+		__attribute__((target("avx512f")))
+		inline void int32ToInt16Avx512(const std::int32_t* first, const std::int32_t* last, std::int16_t* out)
+		{
+			for (; last - first >= 16; first += 16, out += 16)
+			{
+				_mm256_storeu_si256(reinterpret_cast<__m256i*>(out), _mm512_cvtsepi32_epi16(_mm512_loadu_si512(first)));
+			}
+			saturateScalar(first, last, out);
+		}
+
+		__attribute__((target("avx512f")))
+		inline void int32ToUint16Avx512(const std::int32_t* first, const std::int32_t* last, std::uint16_t* out)
+		{
+			for (; last - first >= 16; first += 16, out += 16)
+			{
+				const __m512i values = _mm512_max_epi32(_mm512_loadu_si512(first), _mm512_setzero_si512());
+				_mm256_storeu_si256(reinterpret_cast<__m256i*>(out), _mm512_cvtusepi32_epi16(values));
+			}
+			saturateScalar(first, last, out);
+		}
+
+		template <class To>
+		__attribute__((target("avx512f,avx512bw")))
+		void int16ToByteAvx512(const std::int16_t* first, const std::int16_t* last, To* out)
+		{
+			for (; last - first >= 32; first += 32, out += 32)
+			{
+				const __m512i values = _mm512_loadu_si512(first);
+				const __m256i packed = std::is_signed_v<To> ? _mm512_cvtsepi16_epi8(values) : _mm512_cvtusepi16_epi8(_mm512_max_epi16(values, _mm512_setzero_si512()));
+				_mm256_storeu_si256(reinterpret_cast<__m256i*>(out), packed);
+			}
+			saturateScalar(first, last, out);
+		}
+#endif
+
+		inline std::uint16_t floatToHalf(float value)
+		{
+			std::uint32_t bits;
+			std::memcpy(&bits, &value, sizeof(bits));
+			const auto sign = static_cast<std::uint16_t>((bits >> 16) & 0x8000);
+			const std::uint32_t exponent = (bits >> 23) & 0xFF;
+			std::uint32_t mantissa = bits & 0x7FFFFF;
+
+			if (exponent == 0xFF)
+			{
+				return static_cast<std::uint16_t>(sign | 0x7C00 | (mantissa != 0 ? 0x200 | (mantissa >> 13) : 0));
+			}
+			if (exponent >= 143)
+			{
+				return static_cast<std::uint16_t>(sign | 0x7C00);
+			}
+
+			// the bits below the half precision mantissa are rounded away; a carry may move into the exponent
+			std::uint32_t shift = 13;
+			std::uint32_t half = ((exponent - 112) << 10) | (mantissa >> 13);
+			if (exponent <= 112)
+			{
+				shift = 126 - exponent;
+				if (shift > 24)
+				{
+					return sign;
+				}
+				mantissa |= 0x800000;
+				half = mantissa >> shift;
+			}
+			const std::uint32_t rest = mantissa & ((1u << shift) - 1);
+			const std::uint32_t halfway = 1u << (shift - 1);
+			if (rest > halfway || (rest == halfway && (half & 1) != 0))
+			{
+				++half;
+			}
+			return static_cast<std::uint16_t>(sign | half);
+		}
+
+		template <class To, class From>
+		To saturate(From value)
+		{
+			constexpr To low = std::numeric_limits<To>::min();
+			constexpr To high = std::numeric_limits<To>::max();
+			if constexpr (std::is_floating_point_v<From>)
+			{
+				if (value != value)
+				{
+					return 0;
+				}
+				if (value <= static_cast<From>(low))
+				{
+					return low;
+				}
+				if (value >= static_cast<From>(high))
+				{
+					return high;
+				}
+				return static_cast<To>(value);
+			}
+			else
+			{
+				if constexpr (std::is_signed_v<From>)
+				{
+					if (value < 0)
+					{
+						if constexpr (std::is_signed_v<To>)
+						{
+							return static_cast<std::intmax_t>(value) < static_cast<std::intmax_t>(low) ? low : static_cast<To>(value);
+						}
+						else
+						{
+							return 0;
+						}
+					}
+				}
+				return static_cast<std::uintmax_t>(value) > static_cast<std::uintmax_t>(high) ? high : static_cast<To>(value);
+			}
+		}
+	}
+
+	/// <summary>
+	/// A UnaryOperation for TransformIterator reversing the byte order of 16, 32 or 64 bit integers, converting
+	/// between big and little endian. Its block kernel swaps bytes with pshufb, 16 to 64 bytes at a time
+	/// depending on the instruction set level selected at runtime.
+	/// </summary>
+	template <class T>
+	struct ByteSwap
+	{
+		static_assert(std::is_integral_v<T> && (sizeof(T) == 2 || sizeof(T) == 4 || sizeof(T) == 8), "ByteSwap must be provided a 16, 32 or 64 bit integer.");
+
+		using Kernel = void(const T*, const T*, T*);
+
+		/// <summary>
+		/// Reverses the byte order of a value.
+		/// </summary>
+		[[nodiscard]]
+		static T swap(T value)
+		{
+			return Detail::swapBytes(value);
+		}
+
+		/// <summary>
+		/// Gets the block kernel compiled for the highest level not above isa.
+		/// </summary>
+		[[nodiscard]]
+		static Kernel* kernelFor(Isa isa)
+		{
+			static constexpr KernelVariant<Kernel> variants[] = {
+				{ Isa::Scalar, &Detail::byteSwapScalar<T> },
+#if LAGY_X86_DISPATCH
+				{ Isa::Sse41, &Detail::byteSwapSse41<T> },
+				{ Isa::Avx2, &Detail::byteSwapAvx2<T> },
+				{ Isa::Avx512, &Detail::byteSwapAvx512<T> },
+#endif
+			};
+			return selectKernel(variants, isa);
+		}
+
+		/// <summary>
+		/// Reverses the byte order of the value the iterator refers to.
+		/// </summary>
+		template <class Iterator>
+		[[nodiscard]]
+		T operator()(const Iterator& it) const
+		{
+			return swap(static_cast<T>(*it));
+		}
+
+		/// <summary>
+		/// Reverses the byte order of every value of [first, last), writing the results to out.
+		/// </summary>
+		void applyBlock(const T* first, const T* last, T* out) const
+		{
+			static Kernel* const kernel = kernelFor(activeIsa());
+			kernel(first, last, out);
+		}
+	};
+
+	/// <summary>
+	/// A UnaryOperation for TransformIterator converting numbers to To with static_cast, for example int to float.
+	/// Its block kernel converts 32 bit integers to float 4 to 16 at a time depending on the instruction set
+	/// level selected at runtime, and other types in a plain loop over pointers that the compiler can vectorize.
+	/// </summary>
+	template <class To>
+	struct ConvertTo
+	{
+		static_assert(std::is_arithmetic_v<To>, "ConvertTo must be provided an arithmetic type.");
+
+		template <class From>
+		using Kernel = void(const From*, const From*, To*);
+
+		/// <summary>
+		/// Gets the block kernel compiled for the highest level not above isa.
+		/// </summary>
+		template <class From>
+		[[nodiscard]]
+		static Kernel<From>* kernelFor(Isa isa)
+		{
+#if LAGY_X86_DISPATCH
+			if constexpr (std::is_same_v<From, std::int32_t> && std::is_same_v<To, float>)
+			{
+				static constexpr KernelVariant<Kernel<From>> variants[] = {
+					{ Isa::Scalar, &Detail::convertScalar<From, To> },
+					{ Isa::Sse41, &Detail::int32ToFloatSse41 },
+					{ Isa::Avx2, &Detail::int32ToFloatAvx2 },
+					{ Isa::Avx512, &Detail::int32ToFloatAvx512 },
+				};
+				return selectKernel(variants, isa);
+			}
+#endif
+			static_cast<void>(isa);
+			return &Detail::convertScalar<From, To>;
+		}
+
+		/// <summary>
+		/// Converts the value the iterator refers to.
+		/// </summary>
+		template <class Iterator>
+		[[nodiscard]]
+		To operator()(const Iterator& it) const
+		{
+			return static_cast<To>(*it);
+		}
+
+		/// <summary>
+		/// Converts every value of [first, last), writing the results to out.
+		/// </summary>
+		template <class From, class = std::enable_if_t<std::is_arithmetic_v<From>>>
+		void applyBlock(const From* first, const From* last, To* out) const
+		{
+			static Kernel<From>* const kernel = kernelFor<From>(activeIsa());
+			kernel(first, last, out);
+		}
+	};
+
+	/// <summary>
+	/// A UnaryOperation for TransformIterator converting floats to the bits of IEEE 754 half precision floats,
+	/// rounding to nearest even. Overflows become infinities and NaNs stay quiet NaNs.
+	/// Its block kernel converts 8 values at a time with F16C or 16 with AVX-512 when selected at runtime.
+	/// </summary>
+	struct FloatToHalf
+	{
+		using Kernel = void(const float*, const float*, std::uint16_t*);
+
+		/// <summary>
+		/// Converts a float to the bits of the nearest half precision float.
+		/// </summary>
+		[[nodiscard]]
+		static std::uint16_t convert(float value)
+		{
+			return Detail::floatToHalf(value);
+		}
+
+		/// <summary>
+		/// Gets the block kernel compiled for the highest level not above isa.
+		/// </summary>
+		[[nodiscard]]
+		static Kernel* kernelFor(Isa isa)
+		{
+			static constexpr KernelVariant<Kernel> variants[] = {
+				{ Isa::Scalar, &Detail::floatToHalfScalar },
+#if LAGY_X86_DISPATCH
+				{ Isa::Avx2, &Detail::floatToHalfAvx2 },
+				{ Isa::Avx512, &Detail::floatToHalfAvx512 },
+#endif
+			};
+			return selectKernel(variants, isa);
+		}
+
+		/// <summary>
+		/// Converts the value the iterator refers to.
+		/// </summary>
+		template <class Iterator>
+		[[nodiscard]]
+		std::uint16_t operator()(const Iterator& it) const
+		{
+			return convert(static_cast<float>(*it));
+		}
+
+		/// <summary>
+		/// Converts every value of [first, last), writing the results to out.
+		/// </summary>
+		void applyBlock(const float* first, const float* last, std::uint16_t* out) const
+		{
+			static Kernel* const kernel = kernelFor(activeIsa());
+			kernel(first, last, out);
+		}
+	};
+
+	/// <summary>
+	/// A UnaryOperation for TransformIterator converting numbers to the integral type To, clamping values outside
+	/// its range to its limits; NaNs become zero. Its block kernel narrows 32 bit integers to 16 bit and 16 bit
+	/// to 8 bit with saturating packs, or with the saturating down conversions of AVX-512 when selected at runtime.
+	/// </summary>
+	template <class To>
+	struct SaturateTo
+	{
+		static_assert(std::is_integral_v<To>, "SaturateTo must be provided an integral type.");
+
+		template <class From>
+		using Kernel = void(const From*, const From*, To*);
+
+		/// <summary>
+		/// Converts a value, clamping it to the range of To.
+		/// </summary>
+		template <class From>
+		[[nodiscard]]
+		static To saturate(From value)
+		{
+			return Detail::saturate<To>(value);
+		}
+
+		/// <summary>
+		/// Gets the block kernel compiled for the highest level not above isa.
+		/// </summary>
+		template <class From>
+		[[nodiscard]]
+		static Kernel<From>* kernelFor(Isa isa)
+		{
+#if LAGY_X86_DISPATCH
+			if constexpr (std::is_same_v<From, std::int32_t> && std::is_same_v<To, std::int16_t>)
+			{
+				static constexpr KernelVariant<Kernel<From>> variants[] = {
+					{ Isa::Scalar, &Detail::saturateScalar<From, To> },
+					{ Isa::Sse41, &Detail::int32ToInt16Sse41 },
+					{ Isa::Avx512, &Detail::int32ToInt16Avx512 },
+				};
+				return selectKernel(variants, isa);
+			}
+			else if constexpr (std::is_same_v<From, std::int32_t> && std::is_same_v<To, std::uint16_t>)
+			{
+				static constexpr KernelVariant<Kernel<From>> variants[] = {
+					{ Isa::Scalar, &Detail::saturateScalar<From, To> },
+					{ Isa::Sse41, &Detail::int32ToUint16Sse41 },
+					{ Isa::Avx512, &Detail::int32ToUint16Avx512 },
+				};
+				return selectKernel(variants, isa);
+			}
+			else if constexpr (std::is_same_v<From, std::int16_t> && (std::is_same_v<To, std::int8_t> || std::is_same_v<To, std::uint8_t>))
+			{
+				static constexpr KernelVariant<Kernel<From>> variants[] = {
+					{ Isa::Scalar, &Detail::saturateScalar<From, To> },
+					{ Isa::Sse41, &Detail::int16ToByteSse41<To> },
+					{ Isa::Avx512, &Detail::int16ToByteAvx512<To> },
+				};
+				return selectKernel(variants, isa);
+			}
+#endif
+			static_cast<void>(isa);
+			return &Detail::saturateScalar<From, To>;
+		}
+
+		/// <summary>
+		/// Converts the value the iterator refers to.
+		/// </summary>
+		template <class Iterator>
+		[[nodiscard]]
+		To operator()(const Iterator& it) const
+		{
+			return saturate(*it);
+		}
+
+		/// <summary>
+		/// Converts every value of [first, last), writing the results to out.
+		/// </summary>
+		template <class From, class = std::enable_if_t<std::is_arithmetic_v<From>>>
+		void applyBlock(const From* first, const From* last, To* out) const
+		{
+			static Kernel<From>* const kernel = kernelFor<From>(activeIsa());
+			kernel(first, last, out);
+		}
+	};
+}
@@ -0,0 +1,117 @@
+﻿#include "catch2/catch.hpp"
+#include "Conversions.h"
+#include "BulkTestHelpers.h"
+#include "TransformIterator.h"
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <list>
+#include <vector>
+
+namespace
+{
+	std::vector<std::uint32_t> randomBits(std::size_t count)
+	{
+		std::vector<std::uint32_t> values;
+		std::uint64_t state = 0x9E3779B97F4A7C15ull;
+		for (std::size_t i = 0; i < count; ++i)
+		{
+			state = state * 6364136223846793005ull + 1442695040888963407ull;
+			values.push_back(static_cast<std::uint32_t>(state >> 32));
+		}
+		return values;
+	}
+}
+
+TEST_CASE("ByteSwap converts endianness per element and in blocks", "[Conversions]")
+{
+	REQUIRE(lagy::ByteSwap<std::uint16_t>::swap(0x1234) == 0x3412);
+	REQUIRE(lagy::ByteSwap<std::uint32_t>::swap(0x12345678u) == 0x78563412u);
+	REQUIRE(lagy::ByteSwap<std::uint64_t>::swap(0x0102030405060708ull) == 0x0807060504030201ull);
+	REQUIRE(lagy::ByteSwap<std::int16_t>::swap(std::int16_t{ -2 }) == std::int16_t{ -257 });
+
+	const std::vector<std::uint32_t> bits = randomBits(77);
+	REQUIRE(bulk<std::uint32_t>(bits, lagy::ByteSwap<std::uint32_t>()) == perElement(bits, lagy::ByteSwap<std::uint32_t>()));
+
+	std::vector<std::uint16_t> shorts(bits.begin(), bits.end());
+	REQUIRE(bulk<std::uint16_t>(shorts, lagy::ByteSwap<std::uint16_t>()) == perElement(shorts, lagy::ByteSwap<std::uint16_t>()));
+
+	std::vector<std::uint64_t> longs(bits.begin(), bits.end());
+	REQUIRE(bulk<std::uint64_t>(longs, lagy::ByteSwap<std::uint64_t>()) == perElement(longs, lagy::ByteSwap<std::uint64_t>()));
+}
+
+TEST_CASE("ConvertTo and SaturateTo match per element conversions", "[Conversions]")
+{
+	const std::vector<std::uint32_t> bits = randomBits(101);
+	const std::vector<std::int32_t> ints(bits.begin(), bits.end());
+	REQUIRE(bulk<float>(ints, lagy::ConvertTo<float>()) == perElement(ints, lagy::ConvertTo<float>()));
+
+	REQUIRE(bulk<std::int16_t>(ints, lagy::SaturateTo<std::int16_t>()) == perElement(ints, lagy::SaturateTo<std::int16_t>()));
+	REQUIRE(bulk<std::uint16_t>(ints, lagy::SaturateTo<std::uint16_t>()) == perElement(ints, lagy::SaturateTo<std::uint16_t>()));
+
+	std::vector<std::int16_t> shorts;
+	for (std::int32_t value : ints)
+	{
+		shorts.push_back(static_cast<std::int16_t>(value >> 20));
+	}
+	REQUIRE(bulk<std::uint8_t>(shorts, lagy::SaturateTo<std::uint8_t>()) == perElement(shorts, lagy::SaturateTo<std::uint8_t>()));
+	REQUIRE(bulk<std::int8_t>(shorts, lagy::SaturateTo<std::int8_t>()) == perElement(shorts, lagy::SaturateTo<std::int8_t>()));
+
+	REQUIRE(lagy::SaturateTo<std::int8_t>::saturate(300) == 127);
+	REQUIRE(lagy::SaturateTo<std::int8_t>::saturate(-300) == -128);
+	REQUIRE(lagy::SaturateTo<std::uint8_t>::saturate(-1) == 0);
+	REQUIRE(lagy::SaturateTo<std::uint32_t>::saturate(std::int64_t{ 1 } << 40) == UINT32_MAX);
+	REQUIRE(lagy::SaturateTo<std::int64_t>::saturate(UINT64_MAX) == INT64_MAX);
+	REQUIRE(lagy::SaturateTo<std::int32_t>::saturate(1e20) == INT32_MAX);
+	REQUIRE(lagy::SaturateTo<std::int32_t>::saturate(-1e20f) == INT32_MIN);
+	REQUIRE(lagy::SaturateTo<std::int32_t>::saturate(std::nan("")) == 0);
+	REQUIRE(lagy::SaturateTo<std::int32_t>::saturate(-7.9) == -7);
+}
+
+TEST_CASE("FloatToHalf rounds to nearest even", "[Conversions]")
+{
+	REQUIRE(lagy::FloatToHalf::convert(1.0f) == 0x3C00);
+	REQUIRE(lagy::FloatToHalf::convert(-2.0f) == 0xC000);
+	REQUIRE(lagy::FloatToHalf::convert(65504.0f) == 0x7BFF);
+	REQUIRE(lagy::FloatToHalf::convert(65520.0f) == 0x7C00);
+	REQUIRE(lagy::FloatToHalf::convert(std::numeric_limits<float>::infinity()) == 0x7C00);
+	REQUIRE(lagy::FloatToHalf::convert(std::ldexp(1.0f, -24)) == 0x0001);
+	REQUIRE(lagy::FloatToHalf::convert(std::ldexp(1.0f, -25)) == 0x0000);
+	REQUIRE(lagy::FloatToHalf::convert(std::ldexp(3.0f, -26)) == 0x0001);
+	REQUIRE(lagy::FloatToHalf::convert(1.0f + std::ldexp(1.0f, -11)) == 0x3C00);
+	REQUIRE(lagy::FloatToHalf::convert(1.0f + std::ldexp(3.0f, -11)) == 0x3C02);
+	REQUIRE((lagy::FloatToHalf::convert(std::nanf("")) & 0x7E00) == 0x7E00);
+
+	// the block kernel and the scalar conversion agree on arbitrary bit patterns
+	std::vector<float> floats;
+	for (std::uint32_t bits : randomBits(4096))
+	{
+		// half of the values have exponents around the half precision range, where rounding is interesting
+		if ((bits & 1) != 0)
+		{
+			bits = (bits & 0x807FFFFFu) | ((100 + (bits >> 8) % 48) << 23);
+		}
+		float value;
+		std::memcpy(&value, &bits, sizeof(value));
+		floats.push_back(value);
+	}
+	REQUIRE(bulk<std::uint16_t>(floats, lagy::FloatToHalf()) == perElement(floats, lagy::FloatToHalf()));
+}
+
+TEST_CASE("transformCopy falls back to per element transforms", "[Conversions]")
+{
+	static_assert(lagy::IsContiguousIterator_v<std::vector<int>::const_iterator>);
+	static_assert(lagy::IsContiguousIterator_v<const char*>);
+	static_assert(!lagy::IsContiguousIterator_v<std::list<int>::iterator>);
+	static_assert(!lagy::IsContiguousIterator_v<std::vector<bool>::iterator>);
+	static_assert(lagy::HasBlockKernel_v<lagy::ConvertTo<float>, std::int32_t, float>);
+	static_assert(!lagy::HasBlockKernel_v<lagy::FloatToHalf, double, std::uint16_t>);
+
+	const std::list<std::uint16_t> values{ 0x0102, 0x0304 };
+	const lagy::ByteSwap<std::uint16_t> swap;
+	std::vector<std::uint16_t> out;
+	lagy::transformCopy(lagy::TransformIterator(values.begin(), swap), lagy::TransformIterator(values.end(), swap), std::back_inserter(out));
+	REQUIRE(out == std::vector<std::uint16_t>{ 0x0201, 0x0403 });
+}
@@ -0,0 +1,138 @@
+﻿#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdlib>
+#include <optional>
+#include <string_view>
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#define LAGY_X86_DISPATCH 1
+#include <immintrin.h>
+#else
+#define LAGY_X86_DISPATCH 0
+#endif
+
+namespace lagy {
+
+	/// <summary>
+	/// The instruction set levels bulk kernels are compiled for, in increasing order.
+	/// Sse41 includes SSSE3, Avx2 includes F16C, and Avx512 is AVX-512F with AVX-512BW.
+	/// No kernel is compiled for Sse2 alone; it gates the streaming stores, which need nothing more.
+	/// </summary>
+	enum class Isa
+	{
+		Scalar,
+		Sse2,
+		Sse41,
+		Avx2,
+		Avx512
+	};
+
+	/// <summary>
+	/// Gets the name of an instruction set level, as accepted by parseIsa.
+	/// </summary>
+	[[nodiscard]]
+	inline const char* isaName(Isa isa)
+	{
+		switch (isa)
+		{
+		case Isa::Sse2: return "sse2";
+		case Isa::Sse41: return "sse4.1";
+		case Isa::Avx2: return "avx2";
+		case Isa::Avx512: return "avx512";
+		default: return "scalar";
+		}
+	}
+
+	/// <summary>
+	/// Parses the name of an instruction set level.
+	/// </summary>
+	[[nodiscard]]
+	inline std::optional<Isa> parseIsa(std::string_view name)
+	{
+		for (Isa isa : { Isa::Scalar, Isa::Sse2, Isa::Sse41, Isa::Avx2, Isa::Avx512 })
+		{
+			if (name == isaName(isa))
+			{
+				return isa;
+			}
+		}
+		return std::nullopt;
+	}
+
+	/// <summary>
+	/// Gets the highest instruction set level supported by the processor, using cpuid.
+	/// </summary>
+	[[nodiscard]]
+	inline Isa detectIsa()
+	{
+#if LAGY_X86_DISPATCH
+		__builtin_cpu_init();
+		if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw"))
+		{
+			return Isa::Avx512;
+		}
+		if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("f16c"))
+		{
+			return Isa::Avx2;
+		}
+		if (__builtin_cpu_supports("sse4.1"))
+		{
+			return Isa::Sse41;
+		}
+		if (__builtin_cpu_supports("sse2"))
+		{
+			return Isa::Sse2;
+		}
+#endif
+		return Isa::Scalar;
+	}
+
+	/// <summary>
+	/// Gets the instruction set level bulk kernels are selected for: the detected level, lowered to the level named
+	/// by the LAGY_FORCE_ISA environment variable if it is set. The level is determined once and cached.
+	/// </summary>
+	[[nodiscard]]
+	inline Isa activeIsa()
+	{
+		static const Isa isa = []()
+		{
+			const Isa detected = detectIsa();
+			const char* forced = std::getenv("LAGY_FORCE_ISA");
+			const std::optional<Isa> requested = forced == nullptr ? std::nullopt : parseIsa(forced);
+			return requested ? std::min(*requested, detected) : detected;
+		}();
+		return isa;
+	}
+
+	/// <summary>
+	/// A kernel compiled for an instruction set level.
+	/// </summary>
+	template <class Function>
+	struct KernelVariant
+	{
+		Isa isa;
+		Function* function;
+	};
+
+	/// <summary>
+	/// Selects the kernel for the highest level not above isa from variants in increasing order of level,
+	/// the first of which must be a Scalar variant.
+	/// Bulk operations select their kernel once, for activeIsa(), and cache the function pointer.
+	/// </summary>
+	template <class Function, std::size_t Count>
+	[[nodiscard]]
+	Function* selectKernel(const KernelVariant<Function> (&variants)[Count], Isa isa)
+	{
+		Function* selected = variants[0].function;
+		for (const KernelVariant<Function>& variant : variants)
+		{
+			if (variant.isa <= isa)
+			{
+				selected = variant.function;
+			}
+		}
+		return selected;
+	}
+}
@@ -0,0 +1,169 @@
+﻿#include "catch2/catch.hpp"
+#include "CpuDispatch.h"
+#include "Conversions.h"
+#include "TabulatedTransform.h"
+
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <vector>
+
+namespace
+{
+	std::vector<lagy::Isa> supportedLevels()
+	{
+		std::vector<lagy::Isa> levels;
+		for (lagy::Isa isa : { lagy::Isa::Scalar, lagy::Isa::Sse2, lagy::Isa::Sse41, lagy::Isa::Avx2, lagy::Isa::Avx512 })
+		{
+			if (isa <= lagy::detectIsa())
+			{
+				levels.push_back(isa);
+			}
+		}
+		return levels;
+	}
+
+	template <class Output, class Kernel, class Input>
+	std::vector<Output> runKernel(Kernel* kernel, const std::vector<Input>& input)
+	{
+		std::vector<Output> out(input.size());
+		kernel(input.data(), input.data() + input.size(), out.data());
+		return out;
+	}
+
+	std::vector<std::int32_t> mixedInts(std::size_t count)
+	{
+		std::vector<std::int32_t> values;
+		std::uint64_t state = 0x2545F4914F6CDD1Dull;
+		for (std::size_t i = 0; i < count; ++i)
+		{
+			state = state * 6364136223846793005ull + 1442695040888963407ull;
+			// shift by a varying amount so both small and large magnitudes appear
+			values.push_back(static_cast<std::int32_t>(state >> 32) >> (i % 24));
+		}
+		values.push_back(std::numeric_limits<std::int32_t>::min());
+		values.push_back(std::numeric_limits<std::int32_t>::max());
+		return values;
+	}
+}
+
+TEST_CASE("Instruction set names round trip", "[CpuDispatch]")
+{
+	for (lagy::Isa isa : { lagy::Isa::Scalar, lagy::Isa::Sse2, lagy::Isa::Sse41, lagy::Isa::Avx2, lagy::Isa::Avx512 })
+	{
+		REQUIRE(lagy::parseIsa(lagy::isaName(isa)) == isa);
+	}
+	REQUIRE_FALSE(lagy::parseIsa("neon").has_value());
+	REQUIRE(lagy::activeIsa() <= lagy::detectIsa());
+}
+
+TEST_CASE("selectKernel picks the highest variant not above the level", "[CpuDispatch]")
+{
+	using Kernel = int();
+	static constexpr lagy::KernelVariant<Kernel> variants[] = {
+		{ lagy::Isa::Scalar, []() { return 0; } },
+		{ lagy::Isa::Avx2, []() { return 2; } },
+	};
+	REQUIRE(lagy::selectKernel(variants, lagy::Isa::Scalar)() == 0);
+	REQUIRE(lagy::selectKernel(variants, lagy::Isa::Sse2)() == 0);
+	REQUIRE(lagy::selectKernel(variants, lagy::Isa::Sse41)() == 0);
+	REQUIRE(lagy::selectKernel(variants, lagy::Isa::Avx2)() == 2);
+	REQUIRE(lagy::selectKernel(variants, lagy::Isa::Avx512)() == 2);
+}
+
+TEST_CASE("Every supported kernel level matches the scalar kernels", "[CpuDispatch]")
+{
+	// odd length so every vector width leaves a scalar tail
+	const std::vector<std::int32_t> ints = mixedInts(1001);
+	std::vector<std::int16_t> shorts;
+	std::vector<float> floats;
+	std::vector<std::uint64_t> longs;
+	for (std::int32_t value : ints)
+	{
+		shorts.push_back(static_cast<std::int16_t>(value >> 12));
+		floats.push_back(static_cast<float>(value) / 65536.0f);
+		longs.push_back(static_cast<std::uint64_t>(value) * 0x9E3779B97F4A7C15ull);
+	}
+
+	for (lagy::Isa isa : supportedLevels())
+	{
+		INFO(lagy::isaName(isa));
+
+		REQUIRE(runKernel<std::int16_t>(lagy::ByteSwap<std::int16_t>::kernelFor(isa), shorts) == runKernel<std::int16_t>(lagy::ByteSwap<std::int16_t>::kernelFor(lagy::Isa::Scalar), shorts));
+		REQUIRE(runKernel<std::int32_t>(lagy::ByteSwap<std::int32_t>::kernelFor(isa), ints) == runKernel<std::int32_t>(lagy::ByteSwap<std::int32_t>::kernelFor(lagy::Isa::Scalar), ints));
+		REQUIRE(runKernel<std::uint64_t>(lagy::ByteSwap<std::uint64_t>::kernelFor(isa), longs) == runKernel<std::uint64_t>(lagy::ByteSwap<std::uint64_t>::kernelFor(lagy::Isa::Scalar), longs));
+
+		REQUIRE(runKernel<float>(lagy::ConvertTo<float>::kernelFor<std::int32_t>(isa), ints) == runKernel<float>(lagy::ConvertTo<float>::kernelFor<std::int32_t>(lagy::Isa::Scalar), ints));
+		REQUIRE(runKernel<std::uint16_t>(lagy::FloatToHalf::kernelFor(isa), floats) == runKernel<std::uint16_t>(lagy::FloatToHalf::kernelFor(lagy::Isa::Scalar), floats));
+
+		REQUIRE(runKernel<std::int16_t>(lagy::SaturateTo<std::int16_t>::kernelFor<std::int32_t>(isa), ints) == runKernel<std::int16_t>(lagy::SaturateTo<std::int16_t>::kernelFor<std::int32_t>(lagy::Isa::Scalar), ints));
+		REQUIRE(runKernel<std::uint16_t>(lagy::SaturateTo<std::uint16_t>::kernelFor<std::int32_t>(isa), ints) == runKernel<std::uint16_t>(lagy::SaturateTo<std::uint16_t>::kernelFor<std::int32_t>(lagy::Isa::Scalar), ints));
+		REQUIRE(runKernel<std::int8_t>(lagy::SaturateTo<std::int8_t>::kernelFor<std::int16_t>(isa), shorts) == runKernel<std::int8_t>(lagy::SaturateTo<std::int8_t>::kernelFor<std::int16_t>(lagy::Isa::Scalar), shorts));
+		REQUIRE(runKernel<std::uint8_t>(lagy::SaturateTo<std::uint8_t>::kernelFor<std::int16_t>(isa), shorts) == runKernel<std::uint8_t>(lagy::SaturateTo<std::uint8_t>::kernelFor<std::int16_t>(lagy::Isa::Scalar), shorts));
+	}
+}
+
+TEST_CASE("Kernels at every supported level", "[CpuDispatch][!benchmark]")
+{
+	const std::vector<std::int32_t> ints = mixedInts(1 << 16);
+	std::vector<float> floats;
+	std::vector<std::uint8_t> bytes;
+	for (std::int32_t value : ints)
+	{
+		floats.push_back(static_cast<float>(value) / 65536.0f);
+		bytes.push_back(static_cast<std::uint8_t>(value));
+	}
+	std::vector<std::int32_t> swapped(ints.size());
+	std::vector<float> converted(ints.size());
+	std::vector<std::int16_t> saturated(ints.size());
+	std::vector<std::uint16_t> halves(ints.size());
+	std::vector<std::uint8_t> digits(ints.size());
+
+	using Table = lagy::LookupTable<std::uint8_t, std::uint8_t, 4>;
+	const Table hex([](std::uint8_t nibble) { return static_cast<std::uint8_t>("0123456789abcdef"[nibble]); });
+
+	for (lagy::Isa isa : supportedLevels())
+	{
+		// no kernel is compiled for SSE2 alone, so it would measure the scalar kernels again
+		if (isa == lagy::Isa::Sse2)
+		{
+			continue;
+		}
+		const std::string level = std::string(" (") + lagy::isaName(isa) + ")";
+
+		auto* const byteSwap = lagy::ByteSwap<std::int32_t>::kernelFor(isa);
+		BENCHMARK("ByteSwap<int32_t>" + level)
+		{
+			byteSwap(ints.data(), ints.data() + ints.size(), swapped.data());
+			return swapped.back();
+		};
+
+		auto* const convert = lagy::ConvertTo<float>::kernelFor<std::int32_t>(isa);
+		BENCHMARK("ConvertTo<float> from int32_t" + level)
+		{
+			convert(ints.data(), ints.data() + ints.size(), converted.data());
+			return converted.back();
+		};
+
+		auto* const saturate = lagy::SaturateTo<std::int16_t>::kernelFor<std::int32_t>(isa);
+		BENCHMARK("SaturateTo<int16_t> from int32_t" + level)
+		{
+			saturate(ints.data(), ints.data() + ints.size(), saturated.data());
+			return saturated.back();
+		};
+
+		auto* const toHalf = lagy::FloatToHalf::kernelFor(isa);
+		BENCHMARK("FloatToHalf" + level)
+		{
+			toHalf(floats.data(), floats.data() + floats.size(), halves.data());
+			return halves.back();
+		};
+
+		auto* const lookup = Table::kernelFor(isa);
+		BENCHMARK("LookupTable of 16 bytes" + level)
+		{
+			lookup(&hex[0], bytes.data(), bytes.data() + bytes.size(), digits.data());
+			return digits.back();
+		};
+	}
+}
@@ -0,0 +1,386 @@
+﻿#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include "BulkTransform.h"
+#include "TransformIterator.h"
+
+namespace lagy {
+
+	/// <summary>
+	/// A UnaryOperation for TransformIterator that decodes a dictionary code to a reference to its dictionary entry.
+	/// A TransformIterator over codes with a DictionaryLookup is a DictionaryIterator: the codes stay reachable
+	/// through getWrappedIterator(), so filters and aggregations can work on codes and only decode where needed.
+	/// </summary>
+	template <class Dictionary>
+	class DictionaryLookup
+	{
+	public:
+
+		/// <summary>
+		/// Constructor:
+		/// Refers to a dictionary.
+		/// </summary>
+		/// <param name="dictionary"> The dictionary, indexed by code. Must outlive the operation. </param>
+		explicit DictionaryLookup(const Dictionary& dictionary) :
+			m_dictionary(&dictionary)
+		{
+		}
+
+		/// <summary>
+		/// Gets the dictionary.
+		/// </summary>
+		[[nodiscard]]
+		const Dictionary& dictionary() const
+		{
+			return *m_dictionary;
+		}
+
+		/// <summary>
+		/// Gets the dictionary entry of the code the iterator refers to.
+		/// </summary>
+		template <class CodeIterator>
+		[[nodiscard]]
+		decltype(auto) operator()(const CodeIterator& it) const
+		{
+			return (*m_dictionary)[static_cast<std::size_t>(*it)];
+		}
+
+	private:
+		const Dictionary* m_dictionary;
+	};
+
+	/// <summary>
+	/// An iterator decoding dictionary codes to their entries, with the codes exposed through getWrappedIterator().
+	/// </summary>
+	template <class CodeIterator, class Dictionary>
+	using DictionaryIterator = TransformIterator<CodeIterator, DictionaryLookup<Dictionary>>;
+
+	/// <summary>
+	/// Creates the begin and end iterators decoding the codes of [first, last) with a dictionary.
+	/// </summary>
+	/// <param name="first"> The start of the codes. </param>
+	/// <param name="last"> The end of the codes. </param>
+	/// <param name="dictionary"> The dictionary, indexed by code. Must outlive the iterators. </param>
+	/// <return> The first iterator and the end iterator. </return>
+	template <class CodeIterator, class Dictionary>
+	[[nodiscard]]
+	std::pair<DictionaryIterator<CodeIterator, Dictionary>, DictionaryIterator<CodeIterator, Dictionary>> decodeDictionary(
+		CodeIterator first, CodeIterator last, const Dictionary& dictionary)
+	{
+		const DictionaryLookup<Dictionary> lookup(dictionary);
+		return { DictionaryIterator<CodeIterator, Dictionary>(first, lookup), DictionaryIterator<CodeIterator, Dictionary>(last, lookup) };
+	}
+
+	/// <summary>
+	/// The result of a predicate evaluated once per dictionary entry, used to filter codes without decoding them.
+	/// Records whether the matching codes form one contiguous range, as for range predicates over a sorted
+	/// dictionary, in which case codes are tested with two comparisons instead of a table lookup.
+	/// </summary>
+	class DictionaryFilter
+	{
+	public:
+
+		/// <summary>
+		/// Constructor:
+		/// Evaluates a predicate on every dictionary entry.
+		/// </summary>
+		/// <param name="dictionary"> The dictionary, indexed by code. </param>
+		/// <param name="predicate"> Called once per entry. </param>
+		template <class Dictionary, class Predicate>
+		DictionaryFilter(const Dictionary& dictionary, Predicate&& predicate)
+		{
+			m_matches.reserve(std::size(dictionary));
+			for (const auto& entry : dictionary)
+			{
+				m_matches.push_back(predicate(entry) ? 1 : 0);
+			}
+
+			std::size_t matching = 0;
+			for (std::size_t code = 0; code < m_matches.size(); ++code)
+			{
+				if (m_matches[code] != 0)
+				{
+					m_low = matching == 0 ? code : m_low;
+					m_high = code;
+					++matching;
+				}
+			}
+			m_contiguous = matching == 0 || matching == m_high - m_low + 1;
+			m_empty = matching == 0;
+		}
+
+		/// <summary>
+		/// Checks whether the entry of a code matches.
+		/// </summary>
+		[[nodiscard]]
+		bool matches(std::size_t code) const
+		{
+			return m_matches[code] != 0;
+		}
+
+		/// <summary>
+		/// Checks whether no entry matches.
+		/// </summary>
+		[[nodiscard]]
+		bool empty() const
+		{
+			return m_empty;
+		}
+
+		/// <summary>
+		/// Checks whether the matching codes are exactly [low(), high()].
+		/// </summary>
+		[[nodiscard]]
+		bool contiguous() const
+		{
+			return m_contiguous;
+		}
+
+		/// <summary>
+		/// Gets the lowest matching code.
+		/// </summary>
+		[[nodiscard]]
+		std::size_t low() const
+		{
+			return m_low;
+		}
+
+		/// <summary>
+		/// Gets the highest matching code.
+		/// </summary>
+		[[nodiscard]]
+		std::size_t high() const
+		{
+			return m_high;
+		}
+
+	private:
+		std::vector<std::uint8_t> m_matches;
+		std::size_t m_low = 0;
+		std::size_t m_high = 0;
+		bool m_contiguous = true;
+		bool m_empty = true;
+	};
+
+	namespace Detail
+	{
+		/// <summary>
+		/// Gets a pointer to byte codes stored contiguously in [first, last), or nullptr if they are not.
+		/// </summary>
+		template <class CodeIterator>
+		[[nodiscard]]
+		const std::uint8_t* contiguousByteCodes(const CodeIterator& first, const CodeIterator& last)
+		{
+			using Code = typename std::iterator_traits<CodeIterator>::value_type;
+			if constexpr (!std::is_same_v<Code, std::uint8_t>)
+			{
+				return nullptr;
+			}
+			else if constexpr (IsContiguousIterator_v<CodeIterator>)
+			{
+				return first == last ? nullptr : toAddress(first);
+			}
+			else
+			{
+				return nullptr;
+			}
+		}
+
+		/// <summary>
+		/// Calls consumer(blockStart, mask) for every block of 16 byte codes with the bitmask of codes in [low, high],
+		/// and returns the number of codes left over after the last whole block.
+		/// </summary>
+		template <class MaskConsumer>
+		std::size_t scanByteCodeRange(const std::uint8_t* codes, std::size_t size, std::uint8_t low, std::uint8_t high, MaskConsumer&& consumer)
+		{
+			std::size_t i = 0;
+#if defined(__SSE2__)
+			// code - low is at most high - low exactly when code is in [low, high], in unsigned bytes
+			const __m128i lowVector = _mm_set1_epi8(static_cast<char>(low));
+			const __m128i spanVector = _mm_set1_epi8(static_cast<char>(high - low));
+			for (; i + 16 <= size; i += 16)
+			{
+				const __m128i offsets = _mm_sub_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(codes + i)), lowVector);
+				const __m128i inRange = _mm_cmpeq_epi8(_mm_min_epu8(offsets, spanVector), offsets);
+				consumer(i, static_cast<std::uint32_t>(_mm_movemask_epi8(inRange)));
+			}
+#else
+			static_cast<void>(codes);
+			static_cast<void>(low);
+			static_cast<void>(high);
+			static_cast<void>(consumer);
+#endif
+			return size - i;
+		}
+
+		/// <summary>
+		/// Gets the number of set bits of a value.
+		/// </summary>
+		[[nodiscard]]
+		inline int popCount(std::uint32_t value)
+		{
+#if defined(__GNUC__) || defined(__clang__)
+			return __builtin_popcount(value);
+#else
+			int count = 0;
+			for (; value != 0; value &= value - 1)
+			{
+				++count;
+			}
+			return count;
+#endif
+		}
+
+		/// <summary>
+		/// Gets the index of the lowest set bit of a non-zero value.
+		/// </summary>
+		[[nodiscard]]
+		inline int countTrailingZeros(std::uint32_t value)
+		{
+#if defined(__GNUC__) || defined(__clang__)
+			return __builtin_ctz(value);
+#else
+			int count = 0;
+			for (; (value & 1) == 0; value >>= 1)
+			{
+				++count;
+			}
+			return count;
+#endif
+		}
+	}
+
+	/// <summary>
+	/// Counts the codes of a range of DictionaryIterators whose entries match a filter, without decoding them.
+	/// Contiguous filters over contiguous byte codes compare 16 codes at a time with SSE2.
+	/// </summary>
+	/// <param name="first"> The start of the range. </param>
+	/// <param name="last"> The end of the range. </param>
+	/// <param name="filter"> The filter, evaluated on the dictionary of the range. </param>
+	/// <return> The number of matching codes. </return>
+	template <class CodeIterator, class Dictionary>
+	[[nodiscard]]
+	std::size_t countMatches(const DictionaryIterator<CodeIterator, Dictionary>& first, const DictionaryIterator<CodeIterator, Dictionary>& last, const DictionaryFilter& filter)
+	{
+		if (filter.empty())
+		{
+			return 0;
+		}
+
+		CodeIterator code = first.getWrappedIterator();
+		const CodeIterator& end = last.getWrappedIterator();
+		std::size_t count = 0;
+
+		if (filter.contiguous())
+		{
+			if (const std::uint8_t* bytes = Detail::contiguousByteCodes(code, end); bytes != nullptr && filter.high() <= UINT8_MAX)
+			{
+				const auto size = static_cast<std::size_t>(end - code);
+				const std::size_t rest = Detail::scanByteCodeRange(bytes, size, static_cast<std::uint8_t>(filter.low()), static_cast<std::uint8_t>(filter.high()),
+					[&count](std::size_t, std::uint32_t mask) { count += static_cast<std::size_t>(Detail::popCount(mask)); });
+				code = end - static_cast<typename std::iterator_traits<CodeIterator>::difference_type>(rest);
+			}
+
+			const std::size_t low = filter.low();
+			const std::size_t span = filter.high() - low;
+			for (; code != end; ++code)
+			{
+				count += static_cast<std::size_t>(*code) - low <= span;
+			}
+			return count;
+		}
+
+		for (; code != end; ++code)
+		{
+			count += filter.matches(static_cast<std::size_t>(*code));
+		}
+		return count;
+	}
+
+	/// <summary>
+	/// Writes the positions, relative to first, of the codes whose entries match a filter, without decoding them.
+	/// The matching entries can then be materialized with first[position] only where they are needed.
+	/// Contiguous filters over contiguous byte codes compare 16 codes at a time with SSE2.
+	/// </summary>
+	/// <param name="first"> The start of the range. </param>
+	/// <param name="last"> The end of the range. </param>
+	/// <param name="filter"> The filter, evaluated on the dictionary of the range. </param>
+	/// <param name="out"> The output of positions. </param>
+	/// <return> The end of the output. </return>
+	template <class CodeIterator, class Dictionary, class OutputIterator>
+	OutputIterator selectMatches(const DictionaryIterator<CodeIterator, Dictionary>& first, const DictionaryIterator<CodeIterator, Dictionary>& last,
+		const DictionaryFilter& filter, OutputIterator out)
+	{
+		if (filter.empty())
+		{
+			return out;
+		}
+
+		CodeIterator code = first.getWrappedIterator();
+		const CodeIterator& end = last.getWrappedIterator();
+		std::size_t position = 0;
+
+		if (filter.contiguous())
+		{
+			if (const std::uint8_t* bytes = Detail::contiguousByteCodes(code, end); bytes != nullptr && filter.high() <= UINT8_MAX)
+			{
+				const auto size = static_cast<std::size_t>(end - code);
+				const std::size_t rest = Detail::scanByteCodeRange(bytes, size, static_cast<std::uint8_t>(filter.low()), static_cast<std::uint8_t>(filter.high()),
+					[&out](std::size_t blockStart, std::uint32_t mask)
+					{
+						for (; mask != 0; mask &= mask - 1)
+						{
+							*out++ = blockStart + static_cast<std::size_t>(Detail::countTrailingZeros(mask));
+						}
+					});
+				position = size - rest;
+				code = end - static_cast<typename std::iterator_traits<CodeIterator>::difference_type>(rest);
+			}
+		}
+
+		for (; code != end; ++code, ++position)
+		{
+			if (filter.matches(static_cast<std::size_t>(*code)))
+			{
+				*out++ = position;
+			}
+		}
+		return out;
+	}
+
+	/// <summary>
+	/// Calls consumer(entry, count) once per dictionary entry occurring in a range of DictionaryIterators, with
+	/// its number of occurrences, so aggregations evaluate their operation once per distinct entry.
+	/// </summary>
+	/// <param name="first"> The start of the range. </param>
+	/// <param name="last"> The end of the range. </param>
+	/// <param name="consumer"> Called with each occurring entry and its count, in code order. </param>
+	template <class CodeIterator, class Dictionary, class EntryConsumer>
+	void forEachDistinct(const DictionaryIterator<CodeIterator, Dictionary>& first, const DictionaryIterator<CodeIterator, Dictionary>& last, EntryConsumer&& consumer)
+	{
+		const Dictionary& dictionary = first.getTransform().dictionary();
+		std::vector<std::size_t> counts(std::size(dictionary));
+		for (CodeIterator code = first.getWrappedIterator(), end = last.getWrappedIterator(); code != end; ++code)
+		{
+			++counts[static_cast<std::size_t>(*code)];
+		}
+
+		for (std::size_t code = 0; code < counts.size(); ++code)
+		{
+			if (counts[code] != 0)
+			{
+				consumer(dictionary[code], counts[code]);
+			}
+		}
+	}
+}
@@ -0,0 +1,76 @@
+﻿#include "catch2/catch.hpp"
+#include "DictionaryIterator.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace
+{
+	template <class Code>
+	std::vector<Code> makeCodes(std::size_t size, std::size_t dictionarySize)
+	{
+		std::vector<Code> codes;
+		std::uint32_t state = 7;
+		for (std::size_t i = 0; i < size; ++i)
+		{
+			state = state * 1103515245u + 12345u;
+			codes.push_back(static_cast<Code>((state >> 16) % dictionarySize));
+		}
+		return codes;
+	}
+}
+
+TEST_CASE("DictionaryIterator decodes codes and keeps them exposed", "[DictionaryIterator]")
+{
+	const std::vector<std::string> dictionary{ "apple", "banana", "cherry" };
+	const std::vector<std::uint8_t> codes{ 2, 0, 0, 1, 2 };
+
+	auto [first, last] = lagy::decodeDictionary(codes.begin(), codes.end(), dictionary);
+	REQUIRE(std::vector<std::string>(first, last) == std::vector<std::string>{ "cherry", "apple", "apple", "banana", "cherry" });
+	REQUIRE(&first[3] == &dictionary[1]);
+	REQUIRE(*(first + 4).getWrappedIterator() == 2);
+
+	std::vector<std::pair<std::string, std::size_t>> distinct;
+	lagy::forEachDistinct(first, last, [&distinct](const std::string& entry, std::size_t count) { distinct.emplace_back(entry, count); });
+	REQUIRE(distinct == std::vector<std::pair<std::string, std::size_t>>{ { "apple", 2 }, { "banana", 1 }, { "cherry", 2 } });
+}
+
+TEMPLATE_TEST_CASE("DictionaryFilter scans codes without decoding them", "[DictionaryIterator]", std::uint8_t, std::uint16_t)
+{
+	std::vector<int> dictionary;
+	for (int i = 0; i < 40; ++i)
+	{
+		dictionary.push_back(i * 10);
+	}
+	const std::vector<TestType> codes = makeCodes<TestType>(1001, dictionary.size());
+	auto [first, last] = lagy::decodeDictionary(codes.begin(), codes.end(), dictionary);
+
+	int evaluations = 0;
+	auto check = [&](auto predicate, bool contiguous)
+	{
+		evaluations = 0;
+		const lagy::DictionaryFilter filter(dictionary, [&](int value) { ++evaluations; return predicate(value); });
+		REQUIRE(evaluations == 40);
+		REQUIRE(filter.contiguous() == contiguous);
+
+		std::vector<std::size_t> expected;
+		for (std::size_t i = 0; i < codes.size(); ++i)
+		{
+			if (predicate(first[static_cast<std::ptrdiff_t>(i)]))
+			{
+				expected.push_back(i);
+			}
+		}
+
+		REQUIRE(lagy::countMatches(first, last, filter) == expected.size());
+		std::vector<std::size_t> positions;
+		lagy::selectMatches(first, last, filter, std::back_inserter(positions));
+		REQUIRE(positions == expected);
+	};
+
+	check([](int value) { return value >= 120 && value < 250; }, true);
+	check([](int value) { return value % 70 == 0; }, false);
+	check([](int value) { return value < 0; }, true);
+	check([](int) { return true; }, true);
+}
@@ -0,0 +1,467 @@
+﻿#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <type_traits>
+#include <utility>
+
+#include "CpuDispatch.h"
+
+namespace lagy {
+
+	/// <summary>
+	/// Expression node standing for the value the iterator refers to.
+	/// </summary>
+	struct ArgumentNode
+	{
+		template <class T>
+		[[nodiscard]]
+		constexpr T evaluate(const T& value) const
+		{
+			return value;
+		}
+	};
+
+	/// <summary>
+	/// Expression node holding a constant operand.
+	/// </summary>
+	template <class T>
+	struct ConstantNode
+	{
+		T value;
+
+		template <class U>
+		[[nodiscard]]
+		constexpr T evaluate(const U&) const
+		{
+			return value;
+		}
+	};
+
+	/// <summary>
+	/// Expression node applying Operation, for example std::negate<>, to the value of its operand.
+	/// </summary>
+	template <class Operation, class Operand>
+	struct UnaryNode
+	{
+		Operand operand;
+
+		template <class T>
+		[[nodiscard]]
+		constexpr auto evaluate(const T& value) const -> decltype(Operation{}(operand.evaluate(value)))
+		{
+			return Operation{}(operand.evaluate(value));
+		}
+	};
+
+	/// <summary>
+	/// Expression node applying Operation, for example std::plus<>, to the values of its operands.
+	/// </summary>
+	template <class Operation, class Left, class Right>
+	struct BinaryNode
+	{
+		Left left;
+		Right right;
+
+		template <class T>
+		[[nodiscard]]
+		constexpr auto evaluate(const T& value) const -> decltype(Operation{}(left.evaluate(value), right.evaluate(value)))
+		{
+			return Operation{}(left.evaluate(value), right.evaluate(value));
+		}
+	};
+
+	/// <summary>
+	/// Expression node combining the truth of its operands with std::logical_and<> or std::logical_or<>.
+	/// The right operand is only evaluated when the left one does not decide the result, as with the built-in
+	/// operators, so it may rely on the left one, as in _1 != 0 && 100 / _1 > 2.
+	/// </summary>
+	template <class Operation, class Left, class Right>
+	struct LogicalNode
+	{
+		static_assert(std::is_same_v<Operation, std::logical_and<>> || std::is_same_v<Operation, std::logical_or<>>,
+			"LogicalNode combines its operands with std::logical_and<> or std::logical_or<>.");
+
+		Left left;
+		Right right;
+
+		template <class T>
+		[[nodiscard]]
+		constexpr auto evaluate(const T& value) const -> decltype(static_cast<bool>(left.evaluate(value)) && static_cast<bool>(right.evaluate(value)))
+		{
+			if constexpr (std::is_same_v<Operation, std::logical_and<>>)
+			{
+				return static_cast<bool>(left.evaluate(value)) && static_cast<bool>(right.evaluate(value));
+			}
+			else
+			{
+				return static_cast<bool>(left.evaluate(value)) || static_cast<bool>(right.evaluate(value));
+			}
+		}
+	};
+
+	/// <summary>
+	/// Expression node choosing between two values with a condition. Only the chosen value is evaluated,
+	/// so an operand may rely on the condition, as in select(_1 != 0, 100 / _1, 0). The block kernels still
+	/// compile the choice to a blend when neither operand can trap.
+	/// </summary>
+	template <class Condition, class IfTrue, class IfFalse>
+	struct SelectNode
+	{
+		Condition condition;
+		IfTrue ifTrue;
+		IfFalse ifFalse;
+
+		template <class T>
+		[[nodiscard]]
+		constexpr auto evaluate(const T& value) const -> std::common_type_t<decltype(ifTrue.evaluate(value)), decltype(ifFalse.evaluate(value))>
+		{
+			using Result = std::common_type_t<decltype(ifTrue.evaluate(value)), decltype(ifFalse.evaluate(value))>;
+			if (static_cast<bool>(condition.evaluate(value)))
+			{
+				return static_cast<Result>(ifTrue.evaluate(value));
+			}
+			return static_cast<Result>(ifFalse.evaluate(value));
+		}
+	};
+
+	/// <summary>
+	/// Expression node converting the value of its operand to To with static_cast.
+	/// </summary>
+	template <class To, class Operand>
+	struct CastNode
+	{
+		Operand operand;
+
+		template <class T>
+		[[nodiscard]]
+		constexpr auto evaluate(const T& value) const -> decltype(static_cast<To>(operand.evaluate(value)))
+		{
+			return static_cast<To>(operand.evaluate(value));
+		}
+	};
+
+	/// <summary>
+	/// Function object shifting its left operand left by its right operand.
+	/// </summary>
+	struct ShiftLeft
+	{
+		template <class L, class R>
+		[[nodiscard]]
+		constexpr auto operator()(const L& lhs, const R& rhs) const -> decltype(lhs << rhs)
+		{
+			return lhs << rhs;
+		}
+	};
+
+	/// <summary>
+	/// Function object shifting its left operand right by its right operand.
+	/// </summary>
+	struct ShiftRight
+	{
+		template <class L, class R>
+		[[nodiscard]]
+		constexpr auto operator()(const L& lhs, const R& rhs) const -> decltype(lhs >> rhs)
+		{
+			return lhs >> rhs;
+		}
+	};
+
+	namespace Detail
+	{
+		template <class Node, class Input, class Output>
+		void evaluateBlockScalar(const Node& node, const Input* first, const Input* last, Output* out)
+		{
+			// results are staged in a fixed size buffer: out may alias the input (an in place transform) or the tree,
+			// and the vectorizer of -O2 does not version loops for aliasing
+			using Result = decltype(node.evaluate(*first));
+			constexpr std::ptrdiff_t chunk = 64 / sizeof(Input) > 0 ? 64 / sizeof(Input) : 1;
+			const Node local = node;
+			for (; last - first >= chunk; first += chunk, out += chunk)
+			{
+				Result results[chunk];
+				for (std::ptrdiff_t i = 0; i < chunk; ++i)
+				{
+					results[i] = local.evaluate(first[i]);
+				}
+				for (std::ptrdiff_t i = 0; i < chunk; ++i)
+				{
+					out[i] = static_cast<Output>(results[i]);
+				}
+			}
+			for (; first != last; ++first, ++out)
+			{
+				*out = static_cast<Output>(local.evaluate(*first));
+			}
+		}
+
+#if LAGY_X86_DISPATCH
+		// the same loop compiled for wider registers: flatten inlines the loop and the tree into each variant, which
+		// would otherwise share the one baseline instantiation of evaluateBlockScalar
+
+		template <class Node, class Input, class Output>
+		__attribute__((target("sse4.1"), flatten))
+		void evaluateBlockSse41(const Node& node, const Input* first, const Input* last, Output* out)
+		{
+			evaluateBlockScalar(node, first, last, out);
+		}
+
+		template <class Node, class Input, class Output>
+		__attribute__((target("avx2"), flatten))
+		void evaluateBlockAvx2(const Node& node, const Input* first, const Input* last, Output* out)
+		{
+			evaluateBlockScalar(node, first, last, out);
+		}
+
+		template <class Node, class Input, class Output>
+		__attribute__((target("avx512f,avx512bw"), flatten))
+		void evaluateBlockAvx512(const Node& node, const Input* first, const Input* last, Output* out)
+		{
+			evaluateBlockScalar(node, first, last, out);
+		}
+#endif
+
+		template <class Node, class Input, class = std::void_t<>>
+		struct NodeResult {};
+
+		template <class Node, class Input>
+		struct NodeResult<Node, Input, std::void_t<decltype(std::declval<const Node&>().evaluate(std::declval<const Input&>()))>>
+		{
+			using type = decltype(std::declval<const Node&>().evaluate(std::declval<const Input&>()));
+		};
+	}
+
+	/// <summary>
+	/// A UnaryOperation for TransformIterator built from placeholders, for example _1 * 2 + 1, instead of an
+	/// opaque lambda. Dereferencing a TransformIterator evaluates the expression on the value the wrapped
+	/// iterator refers to, as the equivalent lambda would.
+	///
+	/// The structure of the expression is part of its type: node() is a tree of ArgumentNode, ConstantNode,
+	/// UnaryNode, BinaryNode, LogicalNode, SelectNode and CastNode whose operations are function objects such as std::plus<>.
+	/// The block kernel evaluates the whole tree in one loop over pointers, compiled for each instruction set
+	/// level and selected at runtime, so the expression is vectorized as a single fused kernel.
+	/// </summary>
+	template <class Node>
+	class Expression
+	{
+	public:
+		using NodeType = Node;
+
+		template <class Input, class Output>
+		using Kernel = void(const Node&, const Input*, const Input*, Output*);
+
+		/// <summary>
+		/// Constructor:
+		/// Wraps an expression tree.
+		/// </summary>
+		constexpr explicit Expression(Node node = Node()) :
+			m_node(std::move(node))
+		{
+		}
+
+		/// <summary>
+		/// Gets the expression tree.
+		/// </summary>
+		[[nodiscard]]
+		constexpr const Node& node() const
+		{
+			return m_node;
+		}
+
+		/// <summary>
+		/// Evaluates the expression on a value.
+		/// </summary>
+		template <class T>
+		[[nodiscard]]
+		constexpr auto evaluate(const T& value) const -> typename Detail::NodeResult<Node, T>::type
+		{
+			return m_node.evaluate(value);
+		}
+
+		/// <summary>
+		/// Evaluates the expression on the value the iterator refers to.
+		/// </summary>
+		template <class Iterator>
+		[[nodiscard]]
+		auto operator()(const Iterator& it) const -> decltype(this->evaluate(*it))
+		{
+			return evaluate(*it);
+		}
+
+		/// <summary>
+		/// Gets the block kernel compiled for the highest level not above isa.
+		/// </summary>
+		template <class Input, class Output>
+		[[nodiscard]]
+		static Kernel<Input, Output>* kernelFor(Isa isa)
+		{
+			static constexpr KernelVariant<Kernel<Input, Output>> variants[] = {
+				{ Isa::Scalar, &Detail::evaluateBlockScalar<Node, Input, Output> },
+#if LAGY_X86_DISPATCH
+				{ Isa::Sse41, &Detail::evaluateBlockSse41<Node, Input, Output> },
+				{ Isa::Avx2, &Detail::evaluateBlockAvx2<Node, Input, Output> },
+				{ Isa::Avx512, &Detail::evaluateBlockAvx512<Node, Input, Output> },
+#endif
+			};
+			return selectKernel(variants, isa);
+		}
+
+		/// <summary>
+		/// Evaluates the expression on every value of [first, last), writing the results to out.
+		/// </summary>
+		template <class Input, class Output, class = std::enable_if_t<std::is_convertible_v<typename Detail::NodeResult<Node, Input>::type, Output>>>
+		void applyBlock(const Input* first, const Input* last, Output* out) const
+		{
+			static Kernel<Input, Output>* const kernel = kernelFor<Input, Output>(activeIsa());
+			kernel(m_node, first, last, out);
+		}
+
+	private:
+		Node m_node;
+	};
+
+	template <class T>
+	struct IsExpression : std::false_type {};
+
+	template <class Node>
+	struct IsExpression<Expression<Node>> : std::true_type {};
+
+	/// <summary>
+	/// Whether a type is a placeholder Expression.
+	/// </summary>
+	template <class T>
+	inline constexpr bool IsExpression_v = IsExpression<std::decay_t<T>>::value;
+
+	namespace Detail
+	{
+		template <class T>
+		[[nodiscard]]
+		constexpr auto toNode(T&& operand)
+		{
+			if constexpr (IsExpression_v<T>)
+			{
+				return operand.node();
+			}
+			else
+			{
+				return ConstantNode<std::decay_t<T>>{ std::forward<T>(operand) };
+			}
+		}
+
+		template <class Operation, template <class, class, class> class NodeTemplate = BinaryNode, class L, class R>
+		[[nodiscard]]
+		constexpr auto makeBinary(L&& lhs, R&& rhs)
+		{
+			using Node = NodeTemplate<Operation, decltype(toNode(std::forward<L>(lhs))), decltype(toNode(std::forward<R>(rhs)))>;
+			return Expression<Node>(Node{ toNode(std::forward<L>(lhs)), toNode(std::forward<R>(rhs)) });
+		}
+
+		template <class Operation, class Node>
+		[[nodiscard]]
+		constexpr auto makeUnary(const Expression<Node>& operand)
+		{
+			return Expression<UnaryNode<Operation, Node>>(UnaryNode<Operation, Node>{ operand.node() });
+		}
+
+		template <class L, class R>
+		using EnableIfExpressionOperand = std::enable_if_t<IsExpression_v<L> || IsExpression_v<R>, int>;
+	}
+
+	/// <summary>
+	/// Placeholders for building Expressions.
+	/// </summary>
+	namespace Placeholders
+	{
+		/// <summary>
+		/// The value the iterator refers to.
+		/// </summary>
+		inline constexpr Expression<ArgumentNode> _1{};
+	}
+
+	/// <summary>
+	/// Creates an Expression choosing ifTrue where condition holds and ifFalse elsewhere.
+	/// Only the chosen operand is evaluated for each value, so select(_1 != 0, 100 / _1, 0) never divides by zero.
+	/// Any operand may be a constant.
+	/// </summary>
+	template <class Condition, class IfTrue, class IfFalse>
+	[[nodiscard]]
+	constexpr auto select(Condition&& condition, IfTrue&& ifTrue, IfFalse&& ifFalse)
+	{
+		using Node = SelectNode<decltype(Detail::toNode(std::forward<Condition>(condition))),
+			decltype(Detail::toNode(std::forward<IfTrue>(ifTrue))),
+			decltype(Detail::toNode(std::forward<IfFalse>(ifFalse)))>;
+		return Expression<Node>(Node{ Detail::toNode(std::forward<Condition>(condition)), Detail::toNode(std::forward<IfTrue>(ifTrue)), Detail::toNode(std::forward<IfFalse>(ifFalse)) });
+	}
+
+	/// <summary>
+	/// Creates an Expression converting the value of an expression to To.
+	/// </summary>
+	template <class To, class Node>
+	[[nodiscard]]
+	constexpr auto cast(const Expression<Node>& operand)
+	{
+		return Expression<CastNode<To, Node>>(CastNode<To, Node>{ operand.node() });
+	}
+
+#define LAGY_EXPRESSION_BINARY_OPERATOR(symbol, Operation) \
+	template <class L, class R, Detail::EnableIfExpressionOperand<L, R> = 0> \
+	[[nodiscard]] \
+	constexpr auto operator symbol(L&& lhs, R&& rhs) \
+	{ \
+		return Detail::makeBinary<Operation>(std::forward<L>(lhs), std::forward<R>(rhs)); \
+	}
+
+	LAGY_EXPRESSION_BINARY_OPERATOR(+, std::plus<>)
+	LAGY_EXPRESSION_BINARY_OPERATOR(-, std::minus<>)
+	LAGY_EXPRESSION_BINARY_OPERATOR(*, std::multiplies<>)
+	LAGY_EXPRESSION_BINARY_OPERATOR(/, std::divides<>)
+	LAGY_EXPRESSION_BINARY_OPERATOR(%, std::modulus<>)
+	LAGY_EXPRESSION_BINARY_OPERATOR(&, std::bit_and<>)
+	LAGY_EXPRESSION_BINARY_OPERATOR(|, std::bit_or<>)
+	LAGY_EXPRESSION_BINARY_OPERATOR(^, std::bit_xor<>)
+	LAGY_EXPRESSION_BINARY_OPERATOR(<<, ShiftLeft)
+	LAGY_EXPRESSION_BINARY_OPERATOR(>>, ShiftRight)
+	LAGY_EXPRESSION_BINARY_OPERATOR(==, std::equal_to<>)
+	LAGY_EXPRESSION_BINARY_OPERATOR(!=, std::not_equal_to<>)
+	LAGY_EXPRESSION_BINARY_OPERATOR(<, std::less<>)
+	LAGY_EXPRESSION_BINARY_OPERATOR(<=, std::less_equal<>)
+	LAGY_EXPRESSION_BINARY_OPERATOR(>, std::greater<>)
+	LAGY_EXPRESSION_BINARY_OPERATOR(>=, std::greater_equal<>)
+
+#undef LAGY_EXPRESSION_BINARY_OPERATOR
+
+	template <class L, class R, Detail::EnableIfExpressionOperand<L, R> = 0>
+	[[nodiscard]]
+	constexpr auto operator&&(L&& lhs, R&& rhs)
+	{
+		return Detail::makeBinary<std::logical_and<>, LogicalNode>(std::forward<L>(lhs), std::forward<R>(rhs));
+	}
+
+	template <class L, class R, Detail::EnableIfExpressionOperand<L, R> = 0>
+	[[nodiscard]]
+	constexpr auto operator||(L&& lhs, R&& rhs)
+	{
+		return Detail::makeBinary<std::logical_or<>, LogicalNode>(std::forward<L>(lhs), std::forward<R>(rhs));
+	}
+
+	template <class Node>
+	[[nodiscard]]
+	constexpr auto operator-(const Expression<Node>& operand)
+	{
+		return Detail::makeUnary<std::negate<>>(operand);
+	}
+
+	template <class Node>
+	[[nodiscard]]
+	constexpr auto operator~(const Expression<Node>& operand)
+	{
+		return Detail::makeUnary<std::bit_not<>>(operand);
+	}
+
+	template <class Node>
+	[[nodiscard]]
+	constexpr auto operator!(const Expression<Node>& operand)
+	{
+		return Detail::makeUnary<std::logical_not<>>(operand);
+	}
+}
@@ -0,0 +1,141 @@
+﻿#include "catch2/catch.hpp"
+#include "Expression.h"
+#include "BulkTransform.h"
+#include "BulkTestHelpers.h"
+#include "TransformIterator.h"
+
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <type_traits>
+#include <vector>
+
+using lagy::Placeholders::_1;
+
+namespace
+{
+	std::vector<std::int32_t> sequence(std::int32_t first, std::int32_t count)
+	{
+		std::vector<std::int32_t> values;
+		for (std::int32_t i = 0; i < count; ++i)
+		{
+			values.push_back(first + i * 7);
+		}
+		return values;
+	}
+}
+
+TEST_CASE("Placeholder expressions evaluate like the equivalent lambda", "[Expression]")
+{
+	const std::vector<std::int32_t> values = sequence(-500, 301);
+	const std::vector<std::int32_t> expected = perElement(values, [](const auto& it) { return *it * 2 + 1; });
+
+	REQUIRE(perElement(values, _1 * 2 + 1) == expected);
+	REQUIRE(perElement(values, 1 + 2 * _1) == expected);
+	REQUIRE(perElement(values, _1 + _1 + 1) == expected);
+
+	REQUIRE(perElement(values, -_1 % 5) == perElement(values, [](const auto& it) { return -*it % 5; }));
+	REQUIRE(perElement(values, (~_1 & 0xFF) ^ (_1 >> 3)) == perElement(values, [](const auto& it) { return (~*it & 0xFF) ^ (*it >> 3); }));
+	REQUIRE(perElement(values, ((_1 & 0xFFFF) << 2) | 1) == perElement(values, [](const auto& it) { return ((*it & 0xFFFF) << 2) | 1; }));
+	REQUIRE(perElement(values, _1 / 3 - 4) == perElement(values, [](const auto& it) { return *it / 3 - 4; }));
+}
+
+TEST_CASE("Comparisons, selects and casts", "[Expression]")
+{
+	const std::vector<std::int32_t> values = sequence(-100, 50);
+
+	REQUIRE(perElement(values, _1 > 0) == perElement(values, [](const auto& it) { return *it > 0; }));
+	REQUIRE(perElement(values, _1 >= -10 && _1 < 10) == perElement(values, [](const auto& it) { return *it >= -10 && *it < 10; }));
+	REQUIRE(perElement(values, !(_1 == 5) || _1 != 12) == perElement(values, [](const auto& it) { return !(*it == 5) || *it != 12; }));
+
+	// clamp to [0, 100]
+	const auto clamp = lagy::select(_1 < 0, 0, lagy::select(_1 > 100, 100, _1));
+	REQUIRE(perElement(values, clamp) == perElement(values, [](const auto& it) { return *it < 0 ? 0 : *it > 100 ? 100 : *it; }));
+
+	const auto half = lagy::cast<float>(_1) * 0.5f;
+	REQUIRE(std::is_same_v<decltype(half.evaluate(3)), float>);
+	REQUIRE(half.evaluate(3) == 1.5f);
+	REQUIRE(lagy::cast<std::uint8_t>(_1 + 1).evaluate(255) == 0);
+
+	// only the chosen operand is evaluated, here and in the block kernel
+	const std::vector<std::int32_t> withZero = sequence(-350, 101);
+	const auto guarded = lagy::select(_1 != 0, 1000 / _1, 0);
+	REQUIRE(perElement(withZero, guarded) == perElement(withZero, [](const auto& it) { return *it != 0 ? 1000 / *it : 0; }));
+	REQUIRE(bulk<std::int32_t>(withZero, guarded) == perElement(withZero, guarded));
+
+	// && and || only evaluate their right operand when the left one does not decide the result
+	const auto large = _1 != 0 && 1000 / _1 > 2;
+	REQUIRE(perElement(withZero, large) == perElement(withZero, [](const auto& it) { return *it != 0 && 1000 / *it > 2; }));
+	const auto small = _1 == 0 || 1000 / _1 < 2;
+	REQUIRE(perElement(withZero, small) == perElement(withZero, [](const auto& it) { return *it == 0 || 1000 / *it < 2; }));
+	REQUIRE(bulk<std::uint8_t>(withZero, large) == perElement(perElement(withZero, large), [](const auto& it) { return static_cast<std::uint8_t>(*it); }));
+}
+
+TEST_CASE("Expression structure is part of the type", "[Expression]")
+{
+	const auto expression = _1 * 2 + 1;
+	using Node = std::decay_t<decltype(expression.node())>;
+	using Product = lagy::BinaryNode<std::multiplies<>, lagy::ArgumentNode, lagy::ConstantNode<int>>;
+	REQUIRE(std::is_same_v<Node, lagy::BinaryNode<std::plus<>, Product, lagy::ConstantNode<int>>>);
+	REQUIRE(expression.node().right.value == 1);
+	REQUIRE(expression.node().left.right.value == 2);
+
+	REQUIRE(lagy::IsExpression_v<decltype(expression)>);
+	REQUIRE_FALSE(lagy::IsExpression_v<int>);
+	REQUIRE(std::is_same_v<decltype(lagy::select(_1 > 0, _1, 0))::NodeType,
+		lagy::SelectNode<lagy::BinaryNode<std::greater<>, lagy::ArgumentNode, lagy::ConstantNode<int>>, lagy::ArgumentNode, lagy::ConstantNode<int>>>);
+}
+
+TEST_CASE("Bulk transforms run expressions through their block kernel", "[Expression]")
+{
+	const std::vector<std::int32_t> values = sequence(-5000, 1001);
+
+	const auto affine = _1 * 3 - 7;
+	REQUIRE(lagy::HasBlockKernel_v<decltype(affine), std::int32_t, std::int32_t>);
+	REQUIRE(bulk<std::int32_t>(values, affine) == perElement(values, affine));
+
+	const auto clamp = lagy::select(_1 < 0, 0, lagy::select(_1 > 255, 255, _1));
+	REQUIRE(bulk<std::int32_t>(values, clamp) == perElement(values, clamp));
+
+	const auto scaled = lagy::cast<float>(_1) * 0.25f + 1.0f;
+	REQUIRE(bulk<float>(values, scaled) == perElement(values, scaled));
+
+	const auto positive = _1 > 0;
+	REQUIRE(bulk<std::uint8_t>(values, positive) == perElement(perElement(values, positive), [](const auto& it) { return static_cast<std::uint8_t>(*it); }));
+
+	// in place: the output aliases the input
+	std::vector<std::int32_t> inPlace = values;
+	lagy::transformCopy(lagy::TransformIterator(inPlace.begin(), affine), lagy::TransformIterator(inPlace.end(), affine), inPlace.begin());
+	REQUIRE(inPlace == perElement(values, affine));
+
+	// a list is not contiguous, so the per element path is taken
+	const std::list<std::int32_t> list(values.begin(), values.end());
+	std::vector<std::int32_t> out(list.size());
+	lagy::transformCopy(lagy::TransformIterator(list.begin(), affine), lagy::TransformIterator(list.end(), affine), out.begin());
+	REQUIRE(out == perElement(values, affine));
+}
+
+TEST_CASE("Every supported expression kernel level matches the scalar kernel", "[Expression]")
+{
+	const std::vector<std::int32_t> values = sequence(-3000, 777);
+	const auto expression = lagy::select((_1 & 1) == 0, _1 >> 1, _1 * 3 + 1);
+	using Kernel = decltype(expression)::Kernel<std::int32_t, std::int32_t>;
+
+	auto run = [&](Kernel* kernel)
+	{
+		std::vector<std::int32_t> out(values.size());
+		kernel(expression.node(), values.data(), values.data() + values.size(), out.data());
+		return out;
+	};
+
+	const std::vector<std::int32_t> expected = run(decltype(expression)::kernelFor<std::int32_t, std::int32_t>(lagy::Isa::Scalar));
+	REQUIRE(expected == perElement(values, expression));
+	for (lagy::Isa isa : { lagy::Isa::Sse41, lagy::Isa::Avx2, lagy::Isa::Avx512 })
+	{
+		if (isa <= lagy::detectIsa())
+		{
+			INFO(lagy::isaName(isa));
+			REQUIRE(run(decltype(expression)::kernelFor<std::int32_t, std::int32_t>(isa)) == expected);
+		}
+	}
+}
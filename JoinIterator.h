@@ -0,0 +1,257 @@
+﻿#pragma once
+
+#include <functional>
+#include <iterator>
+#include <type_traits>
+#include <utility>
+
+namespace lagy {
+
+	/// <summary>
+	/// Projection selecting the element of the outer range itself as the inner range.
+	/// </summary>
+	struct JoinElement
+	{
+		template <class Range>
+		[[nodiscard]]
+		constexpr Range& operator()(Range& range) const
+		{
+			return range;
+		}
+	};
+
+	/// <summary>
+	/// Projection selecting the mapped value of a map entry as the inner range, to join a map of ranges.
+	/// </summary>
+	struct JoinMapped
+	{
+		template <class Entry>
+		[[nodiscard]]
+		constexpr auto& operator()(Entry& entry) const
+		{
+			return entry.second;
+		}
+	};
+
+	/// <summary>
+	/// A forward iterator over the elements of a range of ranges, for example a std::vector&lt;std::vector&lt;T&gt;&gt;,
+	/// usable as the wrapped iterator of a TransformIterator. The inner range of each outer element is selected by
+	/// a projection. Empty inner ranges are skipped when the iterator enters them, so dereferencing never has to
+	/// check for them.
+	///
+	/// Stepping through a JoinIterator compares against the end of the inner range on every step; algorithms that
+	/// can work range by range should use forEachSegment, which loops over each inner range directly.
+	/// </summary>
+	template <class OuterIterator, class Projection = JoinElement>
+	class JoinIterator
+	{
+	public:
+
+		using OuterIteratorType = OuterIterator;
+		using InnerIteratorType = decltype(std::begin(std::declval<std::invoke_result_t<const Projection&, typename std::iterator_traits<OuterIterator>::reference>>()));
+
+		// std::iterator_traits types
+		using value_type = typename std::iterator_traits<InnerIteratorType>::value_type;
+		using difference_type = typename std::iterator_traits<InnerIteratorType>::difference_type;
+		using pointer = typename std::iterator_traits<InnerIteratorType>::pointer;
+		using reference = typename std::iterator_traits<InnerIteratorType>::reference;
+		using iterator_category = std::conditional_t<
+			std::is_base_of_v<std::forward_iterator_tag, typename std::iterator_traits<OuterIterator>::iterator_category>,
+			std::forward_iterator_tag,
+			std::input_iterator_tag>;
+
+		JoinIterator() = default;
+
+		/// <summary>
+		/// Constructor:
+		/// Creates an iterator at the first element of the first non-empty inner range in [outer, outerEnd).
+		/// </summary>
+		/// <param name="outer"> The start of the outer range. </param>
+		/// <param name="outerEnd"> The end of the outer range. </param>
+		/// <param name="projection"> Selects the inner range of an outer element. </param>
+		JoinIterator(OuterIterator outer, OuterIterator outerEnd, Projection projection = Projection()) :
+			m_outer(std::move(outer)),
+			m_outerEnd(std::move(outerEnd)),
+			m_projection(std::move(projection))
+		{
+			enterNonEmpty();
+		}
+
+		/// <summary>
+		/// Checks whether the iterator is past the last inner range.
+		/// </summary>
+		[[nodiscard]]
+		bool atEnd() const
+		{
+			return m_outer == m_outerEnd;
+		}
+
+		/// <summary>
+		/// Gets the outer iterator of the current inner range.
+		/// </summary>
+		[[nodiscard]]
+		const OuterIterator& outer() const
+		{
+			return m_outer;
+		}
+
+		/// <summary>
+		/// Gets the inner iterator of the current element.
+		/// </summary>
+		[[nodiscard]]
+		const InnerIteratorType& inner() const
+		{
+			return m_inner;
+		}
+
+		/// <summary>
+		/// Gets the end of the current inner range.
+		/// </summary>
+		[[nodiscard]]
+		const InnerIteratorType& innerEnd() const
+		{
+			return m_innerEnd;
+		}
+
+		/// <summary>
+		/// Gets the inner range of an outer element.
+		/// </summary>
+		[[nodiscard]]
+		decltype(auto) innerRange(const OuterIterator& outer) const
+		{
+			return std::invoke(m_projection, *outer);
+		}
+
+		/// <summary>
+		/// Gets the current element.
+		/// </summary>
+		[[nodiscard]]
+		reference operator*() const
+		{
+			return *m_inner;
+		}
+
+		/// <summary>
+		/// Moves the iterator forward, skipping to the next non-empty inner range at the end of the current one.
+		/// </summary>
+		JoinIterator& operator++()
+		{
+			if (++m_inner == m_innerEnd)
+			{
+				++m_outer;
+				enterNonEmpty();
+			}
+			return *this;
+		}
+
+		/// <summary>
+		/// Moves the iterator forward.
+		/// Returns an iterator at the original position.
+		/// </summary>
+		[[nodiscard]]
+		JoinIterator operator++(int)
+		{
+			JoinIterator out(*this);
+			++(*this);
+			return out;
+		}
+
+		/// <summary>
+		/// Compare iterators for equality. All iterators past the last inner range are equal.
+		/// </summary>
+		[[nodiscard]]
+		friend bool operator==(const JoinIterator& lhs, const JoinIterator& rhs)
+		{
+			return lhs.m_outer == rhs.m_outer && (lhs.atEnd() || lhs.m_inner == rhs.m_inner);
+		}
+
+		/// <summary>
+		/// Compare iterators for inequality.
+		/// </summary>
+		[[nodiscard]]
+		friend bool operator!=(const JoinIterator& lhs, const JoinIterator& rhs)
+		{
+			return !(lhs == rhs);
+		}
+
+	private:
+
+		void enterNonEmpty()
+		{
+			for (; m_outer != m_outerEnd; ++m_outer)
+			{
+				auto&& range = std::invoke(m_projection, *m_outer);
+				m_inner = std::begin(range);
+				m_innerEnd = std::end(range);
+				if (m_inner != m_innerEnd)
+				{
+					return;
+				}
+			}
+			m_inner = InnerIteratorType();
+			m_innerEnd = InnerIteratorType();
+		}
+
+		OuterIterator m_outer{};
+		OuterIterator m_outerEnd{};
+		InnerIteratorType m_inner{};
+		InnerIteratorType m_innerEnd{};
+		Projection m_projection{};
+	};
+
+	/// <summary>
+	/// Creates the begin and end iterators over the elements of every inner range of a range of ranges.
+	/// </summary>
+	/// <param name="ranges"> The range of ranges. Must outlive the iterators. </param>
+	/// <param name="projection"> Selects the inner range of an outer element. </param>
+	/// <return> The first iterator and the end iterator. </return>
+	template <class Ranges, class Projection = JoinElement>
+	[[nodiscard]]
+	auto join(Ranges& ranges, Projection projection = Projection())
+	{
+		using Iterator = JoinIterator<decltype(std::begin(ranges)), Projection>;
+		return std::make_pair(Iterator(std::begin(ranges), std::end(ranges), projection), Iterator(std::end(ranges), std::end(ranges), projection));
+	}
+
+	/// <summary>
+	/// Calls consumer(first, last) once per non-empty part of an inner range in [first, last), with the inner
+	/// iterators, so algorithms can run a tight loop over each inner range without checking the outer range every step.
+	/// </summary>
+	/// <param name="first"> The start of the range. </param>
+	/// <param name="last"> The end of the range. </param>
+	/// <param name="consumer"> Called with the bounds of each inner range. </param>
+	template <class OuterIterator, class Projection, class SegmentConsumer>
+	void forEachSegment(const JoinIterator<OuterIterator, Projection>& first, const JoinIterator<OuterIterator, Projection>& last, SegmentConsumer&& consumer)
+	{
+		if (first == last)
+		{
+			return;
+		}
+		if (first.outer() == last.outer())
+		{
+			consumer(first.inner(), last.inner());
+			return;
+		}
+
+		consumer(first.inner(), first.innerEnd());
+
+		const OuterIterator& lastOuter = last.outer();
+		OuterIterator outer = first.outer();
+		for (++outer; outer != lastOuter; ++outer)
+		{
+			auto&& range = first.innerRange(outer);
+			auto innerFirst = std::begin(range);
+			auto innerLast = std::end(range);
+			if (innerFirst != innerLast)
+			{
+				consumer(innerFirst, innerLast);
+			}
+		}
+
+		// last is either past every inner range or inside a non-empty one
+		if (!last.atEnd() && std::begin(first.innerRange(lastOuter)) != last.inner())
+		{
+			consumer(std::begin(first.innerRange(lastOuter)), last.inner());
+		}
+	}
+}
@@ -0,0 +1,54 @@
+﻿#include "catch2/catch.hpp"
+#include "JoinIterator.h"
+#include "TransformIterator.h"
+
+#include <map>
+#include <string>
+#include <vector>
+
+TEST_CASE("JoinIterator flattens nested ranges and skips empty ones", "[JoinIterator]")
+{
+	std::vector<std::vector<int>> nested{ {}, { 1, 2 }, {}, {}, { 3 }, { 4, 5, 6 }, {} };
+	auto [first, last] = lagy::join(nested);
+	REQUIRE(std::vector<int>(first, last) == std::vector<int>{ 1, 2, 3, 4, 5, 6 });
+	REQUIRE(std::distance(first, last) == 6);
+
+	std::vector<std::vector<int>> allEmpty(3);
+	auto [emptyFirst, emptyLast] = lagy::join(allEmpty);
+	REQUIRE(emptyFirst == emptyLast);
+
+	// elements are reachable through the join
+	*std::next(first, 2) = 30;
+	REQUIRE(nested[4][0] == 30);
+
+	auto square = [](const auto& it) { return *it * *it; };
+	lagy::TransformIterator begin(first, square);
+	lagy::TransformIterator end(last, square);
+	REQUIRE(std::vector<int>(begin, end) == std::vector<int>{ 1, 4, 900, 16, 25, 36 });
+}
+
+TEST_CASE("JoinIterator joins the values of a map and exposes inner segments", "[JoinIterator]")
+{
+	std::map<std::string, std::vector<int>> groups{ { "a", { 1, 2, 3 } }, { "b", {} }, { "c", { 4 } }, { "d", { 5, 6, 7 } } };
+	auto [first, last] = lagy::join(groups, lagy::JoinMapped());
+	REQUIRE(std::vector<int>(first, last) == std::vector<int>{ 1, 2, 3, 4, 5, 6, 7 });
+
+	std::vector<std::vector<int>> segments;
+	auto collect = [&segments](auto segmentFirst, auto segmentLast) { segments.emplace_back(segmentFirst, segmentLast); };
+
+	lagy::forEachSegment(first, last, collect);
+	REQUIRE(segments == std::vector<std::vector<int>>{ { 1, 2, 3 }, { 4 }, { 5, 6, 7 } });
+
+	// partial inner ranges at both ends
+	segments.clear();
+	lagy::forEachSegment(std::next(first, 1), std::next(first, 5), collect);
+	REQUIRE(segments == std::vector<std::vector<int>>{ { 2, 3 }, { 4 }, { 5 } });
+
+	segments.clear();
+	lagy::forEachSegment(std::next(first, 4), std::next(first, 6), collect);
+	REQUIRE(segments == std::vector<std::vector<int>>{ { 5, 6 } });
+
+	segments.clear();
+	lagy::forEachSegment(std::next(first, 3), std::next(first, 4), collect);
+	REQUIRE(segments == std::vector<std::vector<int>>{ { 4 } });
+}
@@ -0,0 +1,342 @@
+﻿#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace lagy {
+
+	/// <summary>
+	/// Hit and miss counters of a memo cache.
+	/// </summary>
+	struct MemoStats
+	{
+		std::uint64_t hits = 0;
+		std::uint64_t misses = 0;
+		std::uint64_t evictions = 0;
+
+		/// <summary>
+		/// Gets the fraction of lookups that were hits.
+		/// </summary>
+		[[nodiscard]]
+		double hitRate() const
+		{
+			const std::uint64_t lookups = hits + misses;
+			return lookups == 0 ? 0.0 : static_cast<double>(hits) / static_cast<double>(lookups);
+		}
+
+		MemoStats& operator+=(const MemoStats& other)
+		{
+			hits += other.hits;
+			misses += other.misses;
+			evictions += other.evictions;
+			return *this;
+		}
+	};
+
+	/// <summary>
+	/// A bounded map from keys to computed values using open addressing.
+	///
+	/// Each key may live in any slot of a window of probeWindow consecutive slots starting at its hash.
+	/// When the window is full, one of its entries is evicted with the CLOCK algorithm: entries are marked
+	/// when inserted or hit, and the window's clock hand clears marks until it finds an unmarked entry to replace.
+	/// Lookups touch at most one window of adjacent slots and the table never grows.
+	/// </summary>
+	template <class Key, class Value, class Hash = std::hash<Key>>
+	class MemoCache
+	{
+	public:
+
+		/// <summary>
+		/// The number of adjacent slots a key may occupy.
+		/// </summary>
+		static constexpr std::size_t probeWindow = 8;
+
+		/// <summary>
+		/// Constructor:
+		/// Creates an empty cache.
+		/// </summary>
+		/// <param name="capacity"> The maximum number of entries. Rounded up to a power of two of at least probeWindow. </param>
+		explicit MemoCache(std::size_t capacity) :
+			m_slots(roundUpToPowerOfTwo(capacity)),
+			m_clockHands(m_slots.size()),
+			m_mask(m_slots.size() - 1)
+		{
+		}
+
+		/// <summary>
+		/// Gets the maximum number of entries.
+		/// </summary>
+		[[nodiscard]]
+		std::size_t capacity() const
+		{
+			return m_slots.size();
+		}
+
+		/// <summary>
+		/// Gets the cached value for a key, counting the lookup as a hit or a miss.
+		/// </summary>
+		/// <param name="key"> The key. </param>
+		/// <return> The cached value, or nullptr if the key is not cached. </return>
+		[[nodiscard]]
+		const Value* find(const Key& key)
+		{
+			const Probe probe = locate(key);
+			if (!probe.found)
+			{
+				++m_stats.misses;
+				return nullptr;
+			}
+
+			++m_stats.hits;
+			Slot& slot = m_slots[*probe.found];
+			slot.referenced = true;
+			return &slot.entry->second;
+		}
+
+		/// <summary>
+		/// Caches a value for a key unless the key is already cached, evicting an entry of its window if it is full.
+		/// </summary>
+		/// <param name="key"> The key. </param>
+		/// <param name="value"> The value computed for the key. </param>
+		/// <return> The cached value, which is the earlier one if the key was already cached. </return>
+		const Value& insert(const Key& key, Value value)
+		{
+			const Probe probe = locate(key);
+			if (probe.found)
+			{
+				return m_slots[*probe.found].entry->second;
+			}
+
+			Slot& slot = m_slots[probe.free ? *probe.free : evict(probe.start)];
+			slot.entry.emplace(key, std::move(value));
+			slot.referenced = true;
+			return slot.entry->second;
+		}
+
+		/// <summary>
+		/// Gets the cached value for a key, computing and caching it on a miss.
+		/// </summary>
+		/// <param name="key"> The key. </param>
+		/// <param name="compute"> Called without arguments to compute the value on a miss. </param>
+		/// <return> The cached value. </return>
+		template <class Compute>
+		const Value& getOrCompute(const Key& key, Compute&& compute)
+		{
+			if (const Value* cached = find(key))
+			{
+				return *cached;
+			}
+			return insert(key, std::invoke(std::forward<Compute>(compute)));
+		}
+
+		/// <summary>
+		/// Gets the hit and miss counters.
+		/// </summary>
+		[[nodiscard]]
+		const MemoStats& stats() const
+		{
+			return m_stats;
+		}
+
+	private:
+
+		struct Slot
+		{
+			std::optional<std::pair<Key, Value>> entry;
+			bool referenced = false;
+		};
+
+		struct Probe
+		{
+			std::size_t start;
+			std::optional<std::size_t> found;
+			std::optional<std::size_t> free;
+		};
+
+		[[nodiscard]]
+		static std::size_t roundUpToPowerOfTwo(std::size_t value)
+		{
+			std::size_t result = probeWindow;
+			while (result < value)
+			{
+				result *= 2;
+			}
+			return result;
+		}
+
+		[[nodiscard]]
+		static std::uint64_t mix(std::uint64_t value)
+		{
+			value = (value ^ (value >> 30)) * 0xBF58476D1CE4E5B9ull;
+			value = (value ^ (value >> 27)) * 0x94D049BB133111EBull;
+			return value ^ (value >> 31);
+		}
+
+		[[nodiscard]]
+		Probe locate(const Key& key) const
+		{
+			Probe probe{ static_cast<std::size_t>(mix(static_cast<std::uint64_t>(m_hash(key)))) & m_mask, std::nullopt, std::nullopt };
+			for (std::size_t i = 0; i < probeWindow; ++i)
+			{
+				const std::size_t index = (probe.start + i) & m_mask;
+				const Slot& slot = m_slots[index];
+				if (!slot.entry)
+				{
+					if (!probe.free)
+					{
+						probe.free = index;
+					}
+				}
+				else if (slot.entry->first == key)
+				{
+					probe.found = index;
+					return probe;
+				}
+			}
+			return probe;
+		}
+
+		[[nodiscard]]
+		std::size_t evict(std::size_t start)
+		{
+			++m_stats.evictions;
+			std::uint8_t& hand = m_clockHands[start];
+			while (true)
+			{
+				const std::size_t index = (start + hand) & m_mask;
+				hand = static_cast<std::uint8_t>((hand + 1) % probeWindow);
+
+				Slot& slot = m_slots[index];
+				if (!slot.referenced)
+				{
+					slot.entry.reset();
+					return index;
+				}
+				slot.referenced = false;
+			}
+		}
+
+		std::vector<Slot> m_slots;
+		std::vector<std::uint8_t> m_clockHands;
+		std::size_t m_mask;
+		MemoStats m_stats;
+		Hash m_hash;
+	};
+
+	/// <summary>
+	/// A UnaryOperation for TransformIterator that caches the result of a pure operation by the value
+	/// the iterator refers to, so repeated input values are only transformed once while they stay cached.
+	///
+	/// Copies of a MemoizedTransform share one cache. With a shard count of zero the cache is not synchronized
+	/// and must only be used from one thread at a time; otherwise the cache is split into that many
+	/// independently locked shards selected by key hash, so threads looking up different keys rarely contend.
+	/// The operation runs outside the shard lock, so it may itself use the same transform; threads missing the
+	/// same key at once may each compute it, and the first result inserted is kept.
+	/// </summary>
+	template <class Key, class Value, class UnaryOperation, class Hash = std::hash<Key>>
+	class MemoizedTransform
+	{
+	public:
+
+		/// <summary>
+		/// Constructor:
+		/// Wraps an operation with a cache.
+		/// </summary>
+		/// <param name="operation"> A pure operation whose result depends only on the value the iterator refers to. </param>
+		/// <param name="capacity"> The maximum number of cached results. </param>
+		/// <param name="shardCount"> The number of locked shards, or zero for an unsynchronized cache. </param>
+		MemoizedTransform(UnaryOperation operation, std::size_t capacity, std::size_t shardCount = 0) :
+			m_operation(std::move(operation)),
+			m_shared(std::make_shared<Shared>(capacity, shardCount))
+		{
+		}
+
+		/// <summary>
+		/// Gets the cached result for the value the iterator refers to, applying the operation on a miss.
+		/// </summary>
+		template <class Iterator>
+		[[nodiscard]]
+		Value operator()(const Iterator& it) const
+		{
+			const Key& key = *it;
+			auto compute = [this, &it]() { return std::invoke(m_operation, it); };
+
+			Shared& shared = *m_shared;
+			if (shared.locks.empty())
+			{
+				return shared.shards.front().getOrCompute(key, compute);
+			}
+
+			const std::size_t shard = static_cast<std::size_t>(Hash{}(key) * 0x9E3779B97F4A7C15ull >> 32) % shared.shards.size();
+			{
+				std::lock_guard lock(shared.locks[shard]);
+				if (const Value* cached = shared.shards[shard].find(key))
+				{
+					return *cached;
+				}
+			}
+
+			Value value = compute();
+			std::lock_guard lock(shared.locks[shard]);
+			return shared.shards[shard].insert(key, std::move(value));
+		}
+
+		/// <summary>
+		/// Gets the combined hit and miss counters of every shard.
+		/// Must not be called concurrently with lookups.
+		/// </summary>
+		[[nodiscard]]
+		MemoStats stats() const
+		{
+			MemoStats total;
+			for (const auto& shard : m_shared->shards)
+			{
+				total += shard.stats();
+			}
+			return total;
+		}
+
+	private:
+
+		struct Shared
+		{
+			std::vector<MemoCache<Key, Value, Hash>> shards;
+			std::vector<std::mutex> locks;
+
+			Shared(std::size_t capacity, std::size_t shardCount) :
+				locks(shardCount)
+			{
+				const std::size_t count = std::max<std::size_t>(1, shardCount);
+				shards.reserve(count);
+				for (std::size_t i = 0; i < count; ++i)
+				{
+					shards.emplace_back((capacity + count - 1) / count);
+				}
+			}
+		};
+
+		UnaryOperation m_operation;
+		std::shared_ptr<Shared> m_shared;
+	};
+
+	/// <summary>
+	/// Wraps an operation producing a Value from an iterator to Key in a MemoizedTransform.
+	/// </summary>
+	/// <param name="operation"> A pure operation whose result depends only on the value the iterator refers to. </param>
+	/// <param name="capacity"> The maximum number of cached results. </param>
+	/// <param name="shardCount"> The number of locked shards, or zero for an unsynchronized cache. </param>
+	template <class Key, class Value, class Hash = std::hash<Key>, class UnaryOperation>
+	[[nodiscard]]
+	MemoizedTransform<Key, Value, UnaryOperation, Hash> memoize(UnaryOperation operation, std::size_t capacity, std::size_t shardCount = 0)
+	{
+		return MemoizedTransform<Key, Value, UnaryOperation, Hash>(std::move(operation), capacity, shardCount);
+	}
+}
\ No newline at end of file
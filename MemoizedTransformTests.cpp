@@ -0,0 +1,128 @@
+﻿#include "catch2/catch.hpp"
+#include "MemoizedTransform.h"
+#include "TransformIterator.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <functional>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+	std::string normalize(const std::string& url)
+	{
+		std::string out = url;
+		std::transform(out.begin(), out.end(), out.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+		return out;
+	}
+}
+
+TEST_CASE("MemoCache evicts with CLOCK when a probe window is full", "[MemoizedTransform]")
+{
+	lagy::MemoCache<int, int> cache(8);
+	REQUIRE(cache.capacity() == 8);
+
+	int computations = 0;
+	auto lookup = [&](int key) { return cache.getOrCompute(key, [&]() { ++computations; return key * 10; }); };
+
+	for (int key = 0; key < 8; ++key)
+	{
+		REQUIRE(lookup(key) == key * 10);
+	}
+	REQUIRE(computations == 8);
+	REQUIRE(cache.stats().evictions == 0);
+
+	// the first eviction clears every mark but the new entry's, which survives the next eviction
+	REQUIRE(lookup(100) == 1000);
+	REQUIRE(cache.stats().evictions == 1);
+	REQUIRE(lookup(200) == 2000);
+	REQUIRE(cache.stats().evictions == 2);
+	REQUIRE(lookup(100) == 1000);
+	REQUIRE(lookup(200) == 2000);
+	REQUIRE(computations == 10);
+	REQUIRE(cache.stats().hits == 2);
+
+	// marked entries are only cleared, never evicted, while their window holds unmarked ones
+	REQUIRE(lookup(300) == 3000);
+	REQUIRE(lookup(300) == 3000);
+	REQUIRE(lookup(400) == 4000);
+	REQUIRE(lookup(300) == 3000);
+	REQUIRE(computations == 12);
+}
+
+TEST_CASE("MemoizedTransform skips recomputing repeated inputs", "[MemoizedTransform]")
+{
+	std::vector<std::string> urls;
+	for (int i = 0; i < 1000; ++i)
+	{
+		urls.push_back(i % 3 == 0 ? "HTTP://A.COM" : (i % 3 == 1 ? "http://B.com" : "Http://C.Com"));
+	}
+
+	std::atomic<int> computations = 0;
+	auto expensive = [&computations](const std::vector<std::string>::const_iterator& it)
+	{
+		++computations;
+		return normalize(*it);
+	};
+
+	SECTION("Single threaded cache")
+	{
+		auto memoized = lagy::memoize<std::string, std::string>(expensive, 64);
+		lagy::TransformIterator begin(urls.cbegin(), memoized);
+		lagy::TransformIterator end(urls.cend(), memoized);
+
+		REQUIRE(std::count(begin, end, std::string("http://a.com")) == 334);
+		REQUIRE(computations == 3);
+		REQUIRE(memoized.stats().misses == 3);
+		REQUIRE(memoized.stats().hitRate() == Approx(997.0 / 1000.0));
+	}
+
+	SECTION("Sharded cache shared between threads")
+	{
+		auto memoized = lagy::memoize<std::string, std::string>(expensive, 64, 4);
+		std::vector<std::thread> threads;
+		std::atomic<int> matches = 0;
+		for (int t = 0; t < 4; ++t)
+		{
+			threads.emplace_back([&]()
+			{
+				lagy::TransformIterator begin(urls.cbegin(), memoized);
+				lagy::TransformIterator end(urls.cend(), memoized);
+				matches += static_cast<int>(std::count(begin, end, std::string("http://b.com")));
+			});
+		}
+		for (auto& thread : threads)
+		{
+			thread.join();
+		}
+
+		// threads missing the same key at once each compute it
+		REQUIRE(matches == 4 * 333);
+		REQUIRE(computations >= 3);
+		REQUIRE(computations <= 4 * 3);
+		REQUIRE(memoized.stats().hits + memoized.stats().misses == 4000);
+	}
+
+	SECTION("The operation may use the sharded cache it is memoized in")
+	{
+		std::function<long long(const int*)> fibonacci;
+		auto memoized = lagy::memoize<int, long long>([&fibonacci](const int* it)
+		{
+			const int n = *it;
+			if (n < 2)
+			{
+				return static_cast<long long>(n);
+			}
+			const int previous[] = { n - 1, n - 2 };
+			return fibonacci(&previous[0]) + fibonacci(&previous[1]);
+		}, 256, 4);
+		fibonacci = [&memoized](const int* it) { return memoized(it); };
+
+		const int n = 60;
+		REQUIRE(fibonacci(&n) == 1548008755920ll);
+		REQUIRE(memoized.stats().misses < 200);
+	}
+}
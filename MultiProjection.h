@@ -0,0 +1,125 @@
+﻿#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#include "TransformIterator.h"
+
+namespace lagy {
+
+	/// <summary>
+	/// A UnaryOperation for TransformIterator that applies several UnaryOperations to the same wrapped
+	/// iterator position and returns all of their results as a tuple.
+	/// Projecting several fields through one TransformIterator loads each element and moves the wrapped
+	/// iterator once, instead of once per projection.
+	/// </summary>
+	template <class... UnaryOperations>
+	class MultiProjection
+	{
+	public:
+		static_assert(sizeof...(UnaryOperations) > 0, "MultiProjection must be provided at least one UnaryOperation.");
+
+		/// <summary>
+		/// Constructor:
+		/// Combines the provided operations.
+		/// </summary>
+		/// <param name="operations"> The operations applied to every wrapped iterator position, in result order. </param>
+		explicit MultiProjection(UnaryOperations... operations) :
+			m_operations(std::move(operations)...)
+		{
+		}
+
+		/// <summary>
+		/// Applies every operation to the iterator.
+		/// </summary>
+		/// <param name="it"> The wrapped iterator. </param>
+		/// <return> A tuple holding the result of each operation in order. </return>
+		template <class Iterator>
+		[[nodiscard]]
+		std::tuple<std::invoke_result_t<const UnaryOperations&, const Iterator&>...> operator()(const Iterator& it) const
+		{
+			return std::apply([&it](const auto&... operation)
+			{
+				return std::tuple<std::invoke_result_t<const UnaryOperations&, const Iterator&>...>(std::invoke(operation, it)...);
+			}, m_operations);
+		}
+
+		/// <summary>
+		/// Gets the operation producing the result at Index.
+		/// </summary>
+		template <std::size_t Index>
+		[[nodiscard]]
+		const auto& get() const
+		{
+			return std::get<Index>(m_operations);
+		}
+
+	private:
+		std::tuple<UnaryOperations...> m_operations;
+	};
+
+	/// <summary>
+	/// Creates a TransformIterator that yields the results of every operation at each position as a tuple.
+	/// </summary>
+	/// <param name="wrapped"> The iterator to be wrapped. </param>
+	/// <param name="operations"> The operations applied to every wrapped iterator position. </param>
+	template <class Iterator, class... UnaryOperations>
+	[[nodiscard]]
+	TransformIterator<Iterator, MultiProjection<UnaryOperations...>> makeMultiProjectionIterator(Iterator wrapped, UnaryOperations... operations)
+	{
+		return TransformIterator<Iterator, MultiProjection<UnaryOperations...>>(std::move(wrapped), MultiProjection<UnaryOperations...>(std::move(operations)...));
+	}
+
+	namespace Detail
+	{
+		template <class Iterator, class... UnaryOperations, class... OutputIterators, std::size_t... Indices>
+		std::tuple<OutputIterators...> projectInto(
+			Iterator first,
+			Iterator last,
+			const MultiProjection<UnaryOperations...>& projection,
+			std::tuple<OutputIterators...> outputs,
+			std::index_sequence<Indices...>)
+		{
+			for (; first != last; ++first)
+			{
+				((*std::get<Indices>(outputs) = std::invoke(projection.template get<Indices>(), first), ++std::get<Indices>(outputs)), ...);
+			}
+			return outputs;
+		}
+	}
+
+	/// <summary>
+	/// Applies every operation of a projection to each position of [first, last) in one pass and writes the
+	/// result of each operation to its own output, producing one array per projected field.
+	/// </summary>
+	/// <param name="first"> The start of the wrapped range. </param>
+	/// <param name="last"> The end of the wrapped range. </param>
+	/// <param name="projection"> The operations to apply. </param>
+	/// <param name="outputs"> One output per operation, in the same order. </param>
+	/// <return> The end of each output. </return>
+	template <class Iterator, class... UnaryOperations, class... OutputIterators>
+	std::tuple<OutputIterators...> projectInto(Iterator first, Iterator last, const MultiProjection<UnaryOperations...>& projection, OutputIterators... outputs)
+	{
+		static_assert(sizeof...(UnaryOperations) == sizeof...(OutputIterators), "projectInto must be provided one output per projection.");
+		return Detail::projectInto(std::move(first), std::move(last), projection, std::tuple<OutputIterators...>(std::move(outputs)...), std::index_sequence_for<UnaryOperations...>());
+	}
+
+	/// <summary>
+	/// Writes the fields of a range of multi-projection TransformIterators to one output per field in one pass.
+	/// </summary>
+	/// <param name="first"> The start of the range. </param>
+	/// <param name="last"> The end of the range. </param>
+	/// <param name="outputs"> One output per operation, in the same order. </param>
+	/// <return> The end of each output. </return>
+	template <class Iterator, class... UnaryOperations, class... OutputIterators>
+	std::tuple<OutputIterators...> projectInto(
+		const TransformIterator<Iterator, MultiProjection<UnaryOperations...>>& first,
+		const TransformIterator<Iterator, MultiProjection<UnaryOperations...>>& last,
+		OutputIterators... outputs)
+	{
+		return projectInto(first.getWrappedIterator(), last.getWrappedIterator(), first.getTransform(), std::move(outputs)...);
+	}
+}
@@ -0,0 +1,61 @@
+﻿#include "catch2/catch.hpp"
+#include "MultiProjection.h"
+#include "TransformIterator.h"
+
+#include <iterator>
+#include <string>
+#include <tuple>
+#include <vector>
+
+namespace
+{
+	struct Trade
+	{
+		std::string symbol;
+		double price;
+		int quantity;
+	};
+
+	using TradeIterator = std::vector<Trade>::const_iterator;
+}
+
+TEST_CASE("MultiProjection computes several projections from one wrapped position", "[MultiProjection]")
+{
+	const std::vector<Trade> trades = { { "abc", 1.5, 10 }, { "def", 2.0, 5 }, { "ghi", 0.5, 40 } };
+	auto symbol = [](const TradeIterator& it) -> const std::string& { return it->symbol; };
+	auto notional = [](const TradeIterator& it) { return it->price * it->quantity; };
+	auto quantity = [](const TradeIterator& it) { return it->quantity; };
+
+	auto begin = lagy::makeMultiProjectionIterator(trades.cbegin(), symbol, notional, quantity);
+	auto end = lagy::makeMultiProjectionIterator(trades.cend(), symbol, notional, quantity);
+
+	SECTION("Dereferencing yields a tuple of every projection")
+	{
+		auto [name, value, count] = *begin;
+		REQUIRE(name == "abc");
+		REQUIRE(value == 15.0);
+		REQUIRE(count == 10);
+
+		// reference results refer to the original element
+		REQUIRE(&std::get<0>(*begin) == &trades[0].symbol);
+	}
+
+	SECTION("The iterator keeps random access of the wrapped iterator")
+	{
+		REQUIRE(std::get<2>(begin[2]) == 40);
+		REQUIRE(end - begin == 3);
+	}
+
+	SECTION("projectInto writes one output per projection in a single pass")
+	{
+		std::vector<std::string> symbols;
+		std::vector<double> notionals(trades.size());
+		std::vector<int> quantities;
+
+		auto outputs = lagy::projectInto(begin, end, std::back_inserter(symbols), notionals.begin(), std::back_inserter(quantities));
+		REQUIRE(std::get<1>(outputs) == notionals.end());
+		REQUIRE(symbols == std::vector<std::string>{ "abc", "def", "ghi" });
+		REQUIRE(notionals == std::vector<double>{ 15.0, 10.0, 20.0 });
+		REQUIRE(quantities == std::vector<int>{ 10, 5, 40 });
+	}
+}
@@ -0,0 +1,488 @@
+﻿#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#if defined(__SSSE3__)
+#include <tmmintrin.h>
+#endif
+
+namespace lagy {
+
+	namespace Detail
+	{
+		[[nodiscard]]
+		constexpr std::array<std::array<std::uint8_t, 16>, 256> makeStreamVByteShuffleTable()
+		{
+			// lane byte k of value v takes data byte (offset of v + k) if k is within the value's length, else zero (0x80)
+			std::array<std::array<std::uint8_t, 16>, 256> table{};
+			for (std::size_t control = 0; control < 256; ++control)
+			{
+				std::size_t offset = 0;
+				for (std::size_t value = 0; value < 4; ++value)
+				{
+					const std::size_t length = ((control >> (2 * value)) & 3) + 1;
+					for (std::size_t k = 0; k < 4; ++k)
+					{
+						table[control][value * 4 + k] = k < length ? static_cast<std::uint8_t>(offset + k) : std::uint8_t{ 0x80 };
+					}
+					offset += length;
+				}
+			}
+			return table;
+		}
+
+		/// <summary>
+		/// The pshufb masks expanding the data of four Stream VByte values, indexed by their control byte.
+		/// </summary>
+		inline constexpr std::array<std::array<std::uint8_t, 16>, 256> streamVByteShuffleTable = makeStreamVByteShuffleTable();
+	}
+
+	/// <summary>
+	/// Codec for blocks of up to 128 unsigned 32 bit integers packed with the bit width of the largest one.
+	///
+	/// A block is a header of two bytes, the bit width and the number of values minus one, followed by the
+	/// values packed least significant bit first. Values are unpacked from unaligned 64 bit windows without
+	/// branches, so the unpacking loop has no dependency between values.
+	/// </summary>
+	struct BitPackedCodec
+	{
+		/// <summary>
+		/// The maximum number of values in a block.
+		/// </summary>
+		static constexpr std::size_t blockValues = 128;
+
+		/// <summary>
+		/// The number of bytes of a block header.
+		/// </summary>
+		static constexpr std::size_t headerBytes = 2;
+
+		/// <summary>
+		/// Appends the blocks encoding [first, last) to out.
+		/// </summary>
+		static void encode(const std::uint32_t* first, const std::uint32_t* last, std::vector<std::uint8_t>& out)
+		{
+			for (; first != last;)
+			{
+				const std::size_t count = std::min<std::size_t>(blockValues, static_cast<std::size_t>(last - first));
+				std::uint32_t combined = 0;
+				for (std::size_t i = 0; i < count; ++i)
+				{
+					combined |= first[i];
+				}
+				std::size_t width = 0;
+				for (; width < 32 && (combined >> width) != 0; ++width)
+				{
+				}
+
+				out.push_back(static_cast<std::uint8_t>(width));
+				out.push_back(static_cast<std::uint8_t>(count - 1));
+				const std::size_t payload = out.size();
+				out.resize(payload + (count * width + 7) / 8);
+				for (std::size_t i = 0; i < count; ++i)
+				{
+					for (std::size_t bit = 0; bit < width; ++bit)
+					{
+						const std::size_t position = i * width + bit;
+						out[payload + position / 8] |= static_cast<std::uint8_t>(((first[i] >> bit) & 1) << (position % 8));
+					}
+				}
+				first += count;
+			}
+		}
+
+		/// <summary>
+		/// Gets the number of values in the block starting at p.
+		/// </summary>
+		[[nodiscard]]
+		static std::size_t blockCount(const std::uint8_t* p)
+		{
+			return std::size_t{ p[1] } + 1;
+		}
+
+		/// <summary>
+		/// Gets the number of bytes of the block starting at p, header included.
+		/// </summary>
+		[[nodiscard]]
+		static std::size_t blockBytes(const std::uint8_t* p)
+		{
+			return 2 + (blockCount(p) * p[0] + 7) / 8;
+		}
+
+		/// <summary>
+		/// Decodes every value of the block starting at p to out.
+		/// Throws std::invalid_argument if the block is truncated, its bit width is above 32 or it counts more than blockValues values.
+		/// </summary>
+		/// <param name="p"> The start of the block. </param>
+		/// <param name="end"> The end of the encoded buffer, bounding reads. </param>
+		/// <param name="out"> Room for blockValues values. </param>
+		static void decode(const std::uint8_t* p, const std::uint8_t* end, std::uint32_t* out)
+		{
+			const auto available = static_cast<std::size_t>(end - p);
+			if (available < headerBytes || blockBytes(p) > available)
+			{
+				throw std::invalid_argument("BitPackedCodec blocks must lie within the encoded buffer.");
+			}
+			if (p[0] > 32)
+			{
+				throw std::invalid_argument("BitPackedCodec blocks must have a bit width of at most 32.");
+			}
+			if (blockCount(p) > blockValues)
+			{
+				throw std::invalid_argument("BitPackedCodec blocks must hold at most blockValues values.");
+			}
+
+			const std::size_t width = p[0];
+			const std::size_t count = blockCount(p);
+			const std::uint8_t* payload = p + 2;
+			const std::uint64_t mask = (std::uint64_t{ 1 } << width) - 1;
+
+			// every value lies within the 64 bits from the byte holding its first bit, since width + 7 < 64 for width <= 32
+			std::size_t i = 0;
+			for (; i < count && (i * width) / 8 + 8 <= static_cast<std::size_t>(end - payload); ++i)
+			{
+				const std::size_t position = i * width;
+				std::uint64_t window;
+				std::memcpy(&window, payload + position / 8, sizeof(window));
+				out[i] = static_cast<std::uint32_t>((window >> (position % 8)) & mask);
+			}
+			for (; i < count; ++i)
+			{
+				const std::size_t position = i * width;
+				std::uint64_t window = 0;
+				std::memcpy(&window, payload + position / 8, static_cast<std::size_t>(end - payload) - position / 8);
+				out[i] = static_cast<std::uint32_t>((window >> (position % 8)) & mask);
+			}
+		}
+	};
+
+	/// <summary>
+	/// Codec for blocks of up to 128 unsigned 32 bit integers in the Stream VByte format: each value is stored in
+	/// one to four little endian bytes, and the lengths are kept apart as two bit codes, four to a control byte.
+	///
+	/// A block is a header of three bytes, the number of values minus one and the number of data bytes,
+	/// followed by the control bytes and the data bytes. With SSSE3, each control byte selects a shuffle that
+	/// expands the data of four values to four 32 bit integers with one pshufb.
+	/// </summary>
+	struct StreamVByteCodec
+	{
+		/// <summary>
+		/// The maximum number of values in a block.
+		/// </summary>
+		static constexpr std::size_t blockValues = 128;
+
+		/// <summary>
+		/// The number of bytes of a block header.
+		/// </summary>
+		static constexpr std::size_t headerBytes = 3;
+
+		/// <summary>
+		/// Appends the blocks encoding [first, last) to out.
+		/// </summary>
+		static void encode(const std::uint32_t* first, const std::uint32_t* last, std::vector<std::uint8_t>& out)
+		{
+			for (; first != last;)
+			{
+				const std::size_t count = std::min<std::size_t>(blockValues, static_cast<std::size_t>(last - first));
+				std::vector<std::uint8_t> controls((count + 3) / 4);
+				std::vector<std::uint8_t> data;
+				for (std::size_t i = 0; i < count; ++i)
+				{
+					const std::uint32_t value = first[i];
+					const std::size_t length = value < (1u << 8) ? 1 : value < (1u << 16) ? 2 : value < (1u << 24) ? 3 : 4;
+					controls[i / 4] |= static_cast<std::uint8_t>((length - 1) << (2 * (i % 4)));
+					for (std::size_t byte = 0; byte < length; ++byte)
+					{
+						data.push_back(static_cast<std::uint8_t>(value >> (8 * byte)));
+					}
+				}
+
+				out.push_back(static_cast<std::uint8_t>(count - 1));
+				out.push_back(static_cast<std::uint8_t>(data.size()));
+				out.push_back(static_cast<std::uint8_t>(data.size() >> 8));
+				out.insert(out.end(), controls.begin(), controls.end());
+				out.insert(out.end(), data.begin(), data.end());
+				first += count;
+			}
+		}
+
+		/// <summary>
+		/// Gets the number of values in the block starting at p.
+		/// </summary>
+		[[nodiscard]]
+		static std::size_t blockCount(const std::uint8_t* p)
+		{
+			return std::size_t{ p[0] } + 1;
+		}
+
+		/// <summary>
+		/// Gets the number of bytes of the block starting at p, header included.
+		/// </summary>
+		[[nodiscard]]
+		static std::size_t blockBytes(const std::uint8_t* p)
+		{
+			return 3 + (blockCount(p) + 3) / 4 + (std::size_t{ p[1] } | std::size_t{ p[2] } << 8);
+		}
+
+		/// <summary>
+		/// Decodes every value of the block starting at p to out.
+		/// Throws std::invalid_argument if the block is truncated, counts more than blockValues values or its values
+		/// need more data bytes than it holds.
+		/// </summary>
+		/// <param name="p"> The start of the block. </param>
+		/// <param name="end"> The end of the encoded buffer, bounding reads. </param>
+		/// <param name="out"> Room for blockValues values. </param>
+		static void decode(const std::uint8_t* p, const std::uint8_t* end, std::uint32_t* out)
+		{
+			const auto available = static_cast<std::size_t>(end - p);
+			if (available < headerBytes || blockBytes(p) > available)
+			{
+				throw std::invalid_argument("StreamVByteCodec blocks must lie within the encoded buffer.");
+			}
+			if (blockCount(p) > blockValues)
+			{
+				throw std::invalid_argument("StreamVByteCodec blocks must hold at most blockValues values.");
+			}
+
+			const std::size_t count = blockCount(p);
+			const std::uint8_t* controls = p + 3;
+			const std::uint8_t* data = controls + (count + 3) / 4;
+			if (dataLength(controls, count) > std::size_t{ p[1] } + (std::size_t{ p[2] } << 8))
+			{
+				throw std::invalid_argument("StreamVByteCodec blocks must hold the data bytes their control bytes describe.");
+			}
+			std::size_t i = 0;
+
+#if defined(__SSSE3__)
+			// whole groups of four whose 16 byte load stays within the buffer
+			for (; i + 4 <= count && end - data >= 16; i += 4)
+			{
+				const std::uint8_t control = controls[i / 4];
+				const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data));
+				const __m128i shuffle = _mm_loadu_si128(reinterpret_cast<const __m128i*>(Detail::streamVByteShuffleTable[control].data()));
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), _mm_shuffle_epi8(bytes, shuffle));
+				data += groupLength(control);
+			}
+#else
+			static_cast<void>(end);
+#endif
+			for (; i < count; ++i)
+			{
+				const std::size_t length = ((controls[i / 4] >> (2 * (i % 4))) & 3) + 1;
+				std::uint32_t value = 0;
+				for (std::size_t byte = 0; byte < length; ++byte)
+				{
+					value |= std::uint32_t{ data[byte] } << (8 * byte);
+				}
+				out[i] = value;
+				data += length;
+			}
+		}
+
+	private:
+
+		[[nodiscard]]
+		static constexpr std::size_t groupLength(std::uint8_t control)
+		{
+			return std::size_t{ 4 } + (control & 3) + ((control >> 2) & 3) + ((control >> 4) & 3) + ((control >> 6) & 3);
+		}
+
+		[[nodiscard]]
+		static std::size_t dataLength(const std::uint8_t* controls, std::size_t count)
+		{
+			std::size_t length = 0;
+			for (std::size_t group = 0; group < count / 4; ++group)
+			{
+				length += groupLength(controls[group]);
+			}
+			for (std::size_t i = count / 4 * 4; i < count; ++i)
+			{
+				length += ((controls[i / 4] >> (2 * (i % 4))) & 3) + 1;
+			}
+			return length;
+		}
+	};
+
+	/// <summary>
+	/// A forward iterator over the unsigned integers of a buffer of blocks encoded with Codec, usable as the
+	/// wrapped iterator of a TransformIterator.
+	///
+	/// A block is decoded into a buffer inside the iterator the first time one of its values is read, so a scan
+	/// decodes every block once, a whole block at a time. advance(n) skips whole blocks by reading their headers
+	/// alone. Copying the iterator copies the decoded buffer.
+	/// Reaching a block that does not fit in the buffer, or decoding a corrupt block, throws std::invalid_argument.
+	/// </summary>
+	template <class Codec>
+	class PackedIntegerIterator
+	{
+	public:
+
+		// std::iterator_traits types
+		using value_type = std::uint32_t;
+		using difference_type = std::ptrdiff_t;
+		using pointer = const std::uint32_t*;
+		using reference = const std::uint32_t&;
+		using iterator_category = std::forward_iterator_tag;
+
+		PackedIntegerIterator() = default;
+
+		/// <summary>
+		/// Constructor:
+		/// Creates an iterator at the first value of an encoded buffer.
+		/// </summary>
+		/// <param name="first"> The start of the buffer. Must outlive the iterator. </param>
+		/// <param name="last"> The end of the buffer. </param>
+		PackedIntegerIterator(const std::uint8_t* first, const std::uint8_t* last) :
+			m_block(first),
+			m_end(last)
+		{
+			readHeader();
+		}
+
+		/// <summary>
+		/// Gets the current value, decoding its block if needed.
+		/// </summary>
+		[[nodiscard]]
+		reference operator*() const
+		{
+			if (m_decoded != m_block)
+			{
+				Codec::decode(m_block, m_end, m_values.data());
+				m_decoded = m_block;
+			}
+			return m_values[m_index];
+		}
+
+		/// <summary>
+		/// Moves to the next value.
+		/// </summary>
+		PackedIntegerIterator& operator++()
+		{
+			if (++m_index == m_count)
+			{
+				nextBlock();
+			}
+			return *this;
+		}
+
+		/// <summary>
+		/// Moves to the next value.
+		/// Returns an iterator at the original value.
+		/// </summary>
+		[[nodiscard]]
+		PackedIntegerIterator operator++(int)
+		{
+			PackedIntegerIterator out(*this);
+			++(*this);
+			return out;
+		}
+
+		/// <summary>
+		/// Moves forward n values, skipping whole blocks by their headers without decoding them.
+		/// </summary>
+		PackedIntegerIterator& advance(std::size_t n)
+		{
+			while (m_block != m_end && n >= m_count - m_index)
+			{
+				n -= m_count - m_index;
+				nextBlock();
+			}
+			m_index += n;
+			return *this;
+		}
+
+		/// <summary>
+		/// Compare iterators for equality of position.
+		/// </summary>
+		[[nodiscard]]
+		friend bool operator==(const PackedIntegerIterator& lhs, const PackedIntegerIterator& rhs)
+		{
+			return lhs.m_block == rhs.m_block && lhs.m_index == rhs.m_index;
+		}
+
+		/// <summary>
+		/// Compare iterators for inequality of position.
+		/// </summary>
+		[[nodiscard]]
+		friend bool operator!=(const PackedIntegerIterator& lhs, const PackedIntegerIterator& rhs)
+		{
+			return !(lhs == rhs);
+		}
+
+	private:
+
+		void nextBlock()
+		{
+			m_block += Codec::blockBytes(m_block);
+			m_index = 0;
+			readHeader();
+		}
+
+		void readHeader()
+		{
+			// the block size is checked before it is trusted to find the next block
+			const auto available = static_cast<std::size_t>(m_end - m_block);
+			if (available != 0 && (available < Codec::headerBytes || Codec::blockBytes(m_block) > available))
+			{
+				throw std::invalid_argument("PackedIntegerIterator blocks must lie within the encoded buffer.");
+			}
+			if (available != 0 && Codec::blockCount(m_block) > Codec::blockValues)
+			{
+				throw std::invalid_argument("PackedIntegerIterator blocks must hold at most blockValues values.");
+			}
+			m_count = available == 0 ? 0 : Codec::blockCount(m_block);
+		}
+
+		const std::uint8_t* m_block = nullptr;
+		const std::uint8_t* m_end = nullptr;
+		std::size_t m_index = 0;
+		std::size_t m_count = 0;
+		mutable const std::uint8_t* m_decoded = nullptr;
+		mutable std::array<std::uint32_t, Codec::blockValues> m_values{};
+	};
+
+	/// <summary>
+	/// A forward iterator over bit-packed unsigned integers.
+	/// </summary>
+	using BitPackedIterator = PackedIntegerIterator<BitPackedCodec>;
+
+	/// <summary>
+	/// A forward iterator over Stream VByte encoded unsigned integers.
+	/// </summary>
+	using StreamVByteIterator = PackedIntegerIterator<StreamVByteCodec>;
+
+	/// <summary>
+	/// Encodes unsigned integers in blocks of Codec.
+	/// </summary>
+	/// <param name="values"> The values. </param>
+	/// <return> The encoded buffer. </return>
+	template <class Codec>
+	[[nodiscard]]
+	std::vector<std::uint8_t> encodePacked(const std::vector<std::uint32_t>& values)
+	{
+		std::vector<std::uint8_t> out;
+		Codec::encode(values.data(), values.data() + values.size(), out);
+		return out;
+	}
+
+	/// <summary>
+	/// Creates the begin and end iterators over the unsigned integers of a buffer encoded with Codec.
+	/// </summary>
+	/// <param name="encoded"> The encoded buffer. Must outlive the iterators. </param>
+	/// <return> The first iterator and the end iterator. </return>
+	template <class Codec>
+	[[nodiscard]]
+	std::pair<PackedIntegerIterator<Codec>, PackedIntegerIterator<Codec>> decodePacked(const std::vector<std::uint8_t>& encoded)
+	{
+		const std::uint8_t* first = encoded.data();
+		const std::uint8_t* last = first + encoded.size();
+		return { PackedIntegerIterator<Codec>(first, last), PackedIntegerIterator<Codec>(last, last) };
+	}
+}
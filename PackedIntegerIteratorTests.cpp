@@ -0,0 +1,124 @@
+﻿#include "catch2/catch.hpp"
+#include "PackedIntegerIterator.h"
+#include "TransformIterator.h"
+
+#include <cstdint>
+#include <numeric>
+#include <stdexcept>
+#include <vector>
+
+namespace
+{
+	std::vector<std::uint32_t> mixedValues()
+	{
+		std::vector<std::uint32_t> values;
+		std::uint32_t state = 12345;
+		for (std::size_t i = 0; i < 1000; ++i)
+		{
+			state = state * 1664525u + 1013904223u;
+			// blocks of different widths, including all zeros and full 32 bit values
+			const std::size_t block = i / 128;
+			const std::uint32_t width = block == 2 ? 0 : block == 5 ? 32 : static_cast<std::uint32_t>(block * 4 + 1);
+			values.push_back(width == 32 ? state : state & ((1u << width) - 1));
+		}
+		return values;
+	}
+}
+
+TEMPLATE_TEST_CASE("PackedIntegerIterator round trips encoded blocks", "[PackedIntegerIterator]", lagy::BitPackedCodec, lagy::StreamVByteCodec)
+{
+	const std::vector<std::uint32_t> values = mixedValues();
+	const std::vector<std::uint8_t> encoded = lagy::encodePacked<TestType>(values);
+	auto [first, last] = lagy::decodePacked<TestType>(encoded);
+	REQUIRE(std::vector<std::uint32_t>(first, last) == values);
+
+	// advance skips whole blocks without decoding them
+	auto it = first;
+	it.advance(130);
+	REQUIRE(*it == values[130]);
+	it.advance(641);
+	REQUIRE(*it == values[771]);
+	it.advance(229);
+	REQUIRE(it == last);
+
+	auto doubled = [](const lagy::PackedIntegerIterator<TestType>& position) { return std::uint64_t{ *position } * 2; };
+	const std::uint64_t sum = std::accumulate(lagy::TransformIterator(first, doubled), lagy::TransformIterator(last, doubled), std::uint64_t{ 0 });
+	REQUIRE(sum == 2 * std::accumulate(values.begin(), values.end(), std::uint64_t{ 0 }));
+}
+
+TEST_CASE("PackedIntegerIterator handles empty and partial buffers", "[PackedIntegerIterator]")
+{
+	const std::vector<std::uint8_t> empty = lagy::encodePacked<lagy::StreamVByteCodec>({});
+	auto [first, last] = lagy::decodePacked<lagy::StreamVByteCodec>(empty);
+	REQUIRE(first == last);
+
+	const std::vector<std::uint32_t> values{ 1, 300, 70000, 20000000, 5 };
+	const std::vector<std::uint8_t> varint = lagy::encodePacked<lagy::StreamVByteCodec>(values);
+	REQUIRE(varint.size() == 3 + 2 + 1 + 2 + 3 + 4 + 1);
+	auto [varintFirst, varintLast] = lagy::decodePacked<lagy::StreamVByteCodec>(varint);
+	REQUIRE(std::vector<std::uint32_t>(varintFirst, varintLast) == values);
+
+	const std::vector<std::uint8_t> packed = lagy::encodePacked<lagy::BitPackedCodec>({ 3, 1, 2 });
+	REQUIRE(packed == std::vector<std::uint8_t>{ 2, 2, 0b100111 });
+}
+
+TEST_CASE("PackedIntegerIterator rejects corrupt blocks", "[PackedIntegerIterator]")
+{
+	std::vector<std::uint32_t> out(lagy::BitPackedCodec::blockValues);
+	auto decode = [&out](auto codec, const std::vector<std::uint8_t>& block)
+	{
+		decltype(codec)::decode(block.data(), block.data() + block.size(), out.data());
+	};
+
+	SECTION("Bit widths above 32")
+	{
+		std::vector<std::uint8_t> block{ 64, 0 };
+		block.resize(2 + 8);
+		REQUIRE_THROWS_AS(decode(lagy::BitPackedCodec(), block), std::invalid_argument);
+	}
+
+	SECTION("Payloads shorter than the header describes")
+	{
+		std::vector<std::uint8_t> bitPacked = lagy::encodePacked<lagy::BitPackedCodec>({ 3, 1, 2, 7, 7 });
+		bitPacked[1] = 127;
+		REQUIRE_THROWS_AS(decode(lagy::BitPackedCodec(), bitPacked), std::invalid_argument);
+		REQUIRE_THROWS_AS(lagy::decodePacked<lagy::BitPackedCodec>(bitPacked), std::invalid_argument);
+
+		const std::vector<std::uint8_t> streamVByte = lagy::encodePacked<lagy::StreamVByteCodec>({ 1, 300, 70000 });
+		const std::vector<std::uint8_t> truncated(streamVByte.begin(), streamVByte.end() - 1);
+		REQUIRE_THROWS_AS(decode(lagy::StreamVByteCodec(), truncated), std::invalid_argument);
+		REQUIRE_THROWS_AS(lagy::decodePacked<lagy::StreamVByteCodec>(truncated), std::invalid_argument);
+		REQUIRE_THROWS_AS(decode(lagy::StreamVByteCodec(), { 0, 0 }), std::invalid_argument);
+	}
+
+	SECTION("Control bytes describing more data than the block holds")
+	{
+		std::vector<std::uint8_t> streamVByte = lagy::encodePacked<lagy::StreamVByteCodec>({ 1, 2, 3, 4 });
+		streamVByte[3] = 0xFF;
+		REQUIRE_THROWS_AS(decode(lagy::StreamVByteCodec(), streamVByte), std::invalid_argument);
+	}
+
+	SECTION("Headers counting more values than a block holds")
+	{
+		std::vector<std::uint8_t> bitPacked{ 1, 128 };
+		bitPacked.resize(2 + (129 + 7) / 8, 0xFF);
+		REQUIRE_THROWS_AS(decode(lagy::BitPackedCodec(), bitPacked), std::invalid_argument);
+		REQUIRE_THROWS_AS(lagy::decodePacked<lagy::BitPackedCodec>(bitPacked), std::invalid_argument);
+
+		std::vector<std::uint8_t> streamVByte{ 128, 129, 0 };
+		streamVByte.resize(3 + (129 + 3) / 4 + 129, 0);
+		REQUIRE_THROWS_AS(decode(lagy::StreamVByteCodec(), streamVByte), std::invalid_argument);
+		REQUIRE_THROWS_AS(lagy::decodePacked<lagy::StreamVByteCodec>(streamVByte), std::invalid_argument);
+	}
+
+	SECTION("A corrupt block after valid ones is reported when it is reached")
+	{
+		std::vector<std::uint32_t> values(300);
+		std::iota(values.begin(), values.end(), 0u);
+		std::vector<std::uint8_t> encoded = lagy::encodePacked<lagy::BitPackedCodec>(values);
+		encoded.pop_back();
+		auto [first, last] = lagy::decodePacked<lagy::BitPackedCodec>(encoded);
+		REQUIRE(*first == 0);
+		REQUIRE_THROWS_AS(first.advance(256), std::invalid_argument);
+	}
+}
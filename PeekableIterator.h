@@ -0,0 +1,202 @@
+﻿#pragma once
+
+#include <array>
+#include <cstddef>
+#include <iterator>
+#include <type_traits>
+#include <utility>
+
+namespace lagy {
+
+	/// <summary>
+	/// An input iterator over a wrapped range, for example an input-only TransformIterator, that caches the
+	/// dereferenced values in a ring buffer of Capacity elements for lookahead and backtracking.
+	///
+	/// peek(i) reads i elements ahead without moving, and rewind(n) moves back over elements still in the buffer.
+	/// Each element of the wrapped range is dereferenced exactly once; values leave the buffer only to make room
+	/// for new ones, oldest first, so lookahead plus rewindable history never exceeds Capacity elements.
+	/// </summary>
+	template <class Iterator, std::size_t Capacity>
+	class PeekableIterator
+	{
+	public:
+		static_assert(Capacity > 0, "PeekableIterator must be provided a non-empty buffer.");
+
+		using WrappedIteratorType = Iterator;
+
+		// std::iterator_traits types
+		using value_type = std::remove_cv_t<std::remove_reference_t<typename std::iterator_traits<Iterator>::reference>>;
+		using difference_type = typename std::iterator_traits<Iterator>::difference_type;
+		using pointer = const value_type*;
+		using reference = const value_type&;
+		using iterator_category = std::input_iterator_tag;
+
+		/// <summary>
+		/// Constructor:
+		/// Creates an iterator at the start of [first, last). Nothing is read until an element is needed.
+		/// </summary>
+		/// <param name="first"> The start of the range. </param>
+		/// <param name="last"> The end of the range. </param>
+		PeekableIterator(Iterator first, Iterator last) :
+			m_next(std::move(first)),
+			m_last(std::move(last))
+		{
+		}
+
+		/// <summary>
+		/// Constructor:
+		/// Creates the end iterator.
+		/// </summary>
+		explicit PeekableIterator(Iterator last) :
+			m_next(last),
+			m_last(std::move(last))
+		{
+		}
+
+		/// <summary>
+		/// Gets the element i steps ahead of the current one without moving, reading it from the wrapped range if needed.
+		/// </summary>
+		/// <param name="i"> The lookahead distance. Must be less than Capacity. </param>
+		/// <return> The element, or nullptr if the range ends before it. </return>
+		[[nodiscard]]
+		pointer peek(std::size_t i = 0) const
+		{
+			const std::size_t wanted = m_position + i;
+			while (m_filled <= wanted)
+			{
+				if (m_next == m_last)
+				{
+					return nullptr;
+				}
+				if (m_filled - m_oldest == Capacity)
+				{
+					++m_oldest;
+				}
+				m_buffer[m_filled % Capacity] = *m_next;
+				++m_next;
+				++m_filled;
+			}
+			return &m_buffer[wanted % Capacity];
+		}
+
+		/// <summary>
+		/// Gets the current element.
+		/// </summary>
+		[[nodiscard]]
+		reference operator*() const
+		{
+			return *peek(0);
+		}
+
+		/// <summary>
+		/// Gets the current element.
+		/// </summary>
+		[[nodiscard]]
+		pointer operator->() const
+		{
+			return peek(0);
+		}
+
+		/// <summary>
+		/// Moves the iterator forward. The element stays in the buffer and can be returned to with rewind.
+		/// </summary>
+		PeekableIterator& operator++()
+		{
+			if (m_position == m_filled)
+			{
+				static_cast<void>(peek(0));
+			}
+			++m_position;
+			return *this;
+		}
+
+		/// <summary>
+		/// Moves the iterator forward.
+		/// Returns a copy at the original position, which shares the wrapped range and must not be advanced.
+		/// </summary>
+		[[nodiscard]]
+		PeekableIterator operator++(int)
+		{
+			PeekableIterator out(*this);
+			++(*this);
+			return out;
+		}
+
+		/// <summary>
+		/// Gets the number of steps the iterator can move back with rewind.
+		/// </summary>
+		[[nodiscard]]
+		std::size_t rewindable() const
+		{
+			return m_position - m_oldest;
+		}
+
+		/// <summary>
+		/// Moves the iterator back over elements still in the buffer without reading the wrapped range.
+		/// </summary>
+		/// <param name="steps"> The number of steps. Must not exceed rewindable(). </param>
+		PeekableIterator& rewind(std::size_t steps)
+		{
+			m_position -= steps;
+			return *this;
+		}
+
+		/// <summary>
+		/// Gets the number of elements moved past since the start of the range.
+		/// </summary>
+		[[nodiscard]]
+		std::size_t position() const
+		{
+			return m_position;
+		}
+
+		/// <summary>
+		/// Compare iterators for equality. Iterators are equal when both are at the end,
+		/// or when neither is and they are at the same position.
+		/// </summary>
+		[[nodiscard]]
+		friend bool operator==(const PeekableIterator& lhs, const PeekableIterator& rhs)
+		{
+			const bool lhsAtEnd = lhs.atEnd();
+			return lhsAtEnd == rhs.atEnd() && (lhsAtEnd || lhs.m_position == rhs.m_position);
+		}
+
+		/// <summary>
+		/// Compare iterators for inequality.
+		/// </summary>
+		[[nodiscard]]
+		friend bool operator!=(const PeekableIterator& lhs, const PeekableIterator& rhs)
+		{
+			return !(lhs == rhs);
+		}
+
+	private:
+
+		[[nodiscard]]
+		bool atEnd() const
+		{
+			return m_position == m_filled && m_next == m_last;
+		}
+
+		// positions count elements from the start of the range; position p is stored at m_buffer[p % Capacity]
+		mutable Iterator m_next;
+		Iterator m_last;
+		mutable std::array<value_type, Capacity> m_buffer{};
+		mutable std::size_t m_oldest = 0;
+		mutable std::size_t m_filled = 0;
+		std::size_t m_position = 0;
+	};
+
+	/// <summary>
+	/// Creates the begin and end iterators of a peekable view of [first, last).
+	/// </summary>
+	/// <param name="first"> The start of the range. </param>
+	/// <param name="last"> The end of the range. </param>
+	/// <return> The first iterator and the end iterator. </return>
+	template <std::size_t Capacity, class Iterator>
+	[[nodiscard]]
+	std::pair<PeekableIterator<Iterator, Capacity>, PeekableIterator<Iterator, Capacity>> peekable(Iterator first, Iterator last)
+	{
+		return { PeekableIterator<Iterator, Capacity>(first, last), PeekableIterator<Iterator, Capacity>(last) };
+	}
+}
@@ -0,0 +1,80 @@
+﻿#include "catch2/catch.hpp"
+#include "PeekableIterator.h"
+#include "TransformIterator.h"
+
+#include <iterator>
+#include <sstream>
+#include <string>
+#include <vector>
+
+TEST_CASE("PeekableIterator looks ahead and rewinds without re-evaluating transforms", "[PeekableIterator]")
+{
+	std::vector<int> values{ 1, 2, 3, 4, 5, 6 };
+	int evaluations = 0;
+	auto counted = [&evaluations](const std::vector<int>::iterator& it) { ++evaluations; return *it * 10; };
+	lagy::TransformIterator begin(values.begin(), counted);
+	lagy::TransformIterator end(values.end(), counted);
+
+	auto [it, last] = lagy::peekable<3>(begin, end);
+	REQUIRE(evaluations == 0);
+
+	REQUIRE(*it.peek(2) == 30);
+	REQUIRE(*it == 10);
+	REQUIRE(evaluations == 3);
+
+	++it;
+	++it;
+	REQUIRE(it.rewindable() == 2);
+	REQUIRE(*it.peek(0) == 30);
+
+	// peeking further evicts the oldest value
+	REQUIRE(*it.peek(1) == 40);
+	REQUIRE(it.rewindable() == 1);
+	it.rewind(1);
+	REQUIRE(*it == 20);
+	REQUIRE(evaluations == 4);
+
+	std::vector<int> rest;
+	for (; it != last; ++it)
+	{
+		rest.push_back(*it);
+	}
+	REQUIRE(rest == std::vector<int>{ 20, 30, 40, 50, 60 });
+	REQUIRE(evaluations == 6);
+	REQUIRE(it.peek(0) == nullptr);
+}
+
+TEST_CASE("PeekableIterator backtracks over an input-only stream", "[PeekableIterator]")
+{
+	std::istringstream input("let x = 1 ; let y == 2 ;");
+	auto [it, last] = lagy::peekable<4>(std::istream_iterator<std::string>(input), std::istream_iterator<std::string>());
+
+	// a tiny parser: count assignments, backtracking to skip a malformed statement
+	int assignments = 0;
+	int malformed = 0;
+	while (it != last)
+	{
+		const std::string* op = it.peek(2);
+		if (*it == "let" && op != nullptr && *op == "=")
+		{
+			++assignments;
+			std::advance(it, 5);
+			continue;
+		}
+
+		++it;
+		REQUIRE(it.rewindable() >= 1);
+		it.rewind(1);
+		++malformed;
+		while (it != last && *it != ";")
+		{
+			++it;
+		}
+		if (it != last)
+		{
+			++it;
+		}
+	}
+	REQUIRE(assignments == 1);
+	REQUIRE(malformed == 1);
+}
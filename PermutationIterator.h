@@ -0,0 +1,334 @@
+﻿#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+
+namespace lagy {
+
+	/// <summary>
+	/// A keyed pseudo-random bijection of [0, size).
+	/// Indices are enciphered with a balanced Feistel network over the smallest even number of bits
+	/// covering size; results outside the range are enciphered again (cycle walking) until they land inside it.
+	/// Every key gives a different permutation and no state beyond the round keys is stored.
+	/// </summary>
+	class RandomPermutation
+	{
+	public:
+
+		/// <summary>
+		/// Constructor:
+		/// Creates the permutation of [0, size) selected by key.
+		/// </summary>
+		/// <param name="size"> The number of elements permuted. </param>
+		/// <param name="key"> The key selecting the permutation. </param>
+		explicit RandomPermutation(std::uint64_t size = 0, std::uint64_t key = 0) :
+			m_size(size)
+		{
+			std::uint32_t bits = 1;
+			while (bits < 32 && (std::uint64_t{ 1 } << (2 * bits)) < size)
+			{
+				++bits;
+			}
+			m_halfBits = bits;
+			m_halfMask = (bits >= 32) ? 0xFFFFFFFFu : ((std::uint64_t{ 1 } << bits) - 1);
+
+			for (std::uint64_t& roundKey : m_roundKeys)
+			{
+				key = mix(key + 0x9E3779B97F4A7C15ull);
+				roundKey = key;
+			}
+		}
+
+		/// <summary>
+		/// Gets the number of elements permuted.
+		/// </summary>
+		[[nodiscard]]
+		std::uint64_t size() const
+		{
+			return m_size;
+		}
+
+		/// <summary>
+		/// Maps an index to its position in the permutation.
+		/// </summary>
+		/// <param name="index"> An index in [0, size). </param>
+		/// <return> The permuted index, also in [0, size). </return>
+		[[nodiscard]]
+		std::uint64_t operator()(std::uint64_t index) const
+		{
+			do
+			{
+				index = encipher(index);
+			} while (index >= m_size);
+			return index;
+		}
+
+	private:
+
+		static constexpr int rounds = 4;
+
+		[[nodiscard]]
+		static std::uint64_t mix(std::uint64_t value)
+		{
+			value = (value ^ (value >> 30)) * 0xBF58476D1CE4E5B9ull;
+			value = (value ^ (value >> 27)) * 0x94D049BB133111EBull;
+			return value ^ (value >> 31);
+		}
+
+		[[nodiscard]]
+		std::uint64_t encipher(std::uint64_t value) const
+		{
+			std::uint64_t left = (value >> m_halfBits) & m_halfMask;
+			std::uint64_t right = value & m_halfMask;
+			for (std::uint64_t roundKey : m_roundKeys)
+			{
+				const std::uint64_t next = left ^ (mix(right ^ roundKey) & m_halfMask);
+				left = right;
+				right = next;
+			}
+			return (left << m_halfBits) | right;
+		}
+
+		std::uint64_t m_size;
+		std::uint32_t m_halfBits;
+		std::uint64_t m_halfMask;
+		std::uint64_t m_roundKeys[rounds];
+	};
+
+	/// <summary>
+	/// A random access iterator over a RandomPermutation of [0, size).
+	/// Visits every index exactly once in pseudo-random order using O(1) memory, and computes any
+	/// position directly so ranges can be split between threads.
+	/// Usable as the wrapped iterator of a TransformIterator, for example to index a container.
+	///
+	/// Dereferencing returns values rather than references. Iterators compare by position only.
+	/// </summary>
+	class PermutationIterator
+	{
+	public:
+
+		// std::iterator_traits types
+		using value_type = std::uint64_t;
+		using difference_type = std::ptrdiff_t;
+		using pointer = const std::uint64_t*;
+		using reference = std::uint64_t;
+		using iterator_category = std::random_access_iterator_tag;
+
+		/// <summary>
+		/// Constructor:
+		/// Creates an iterator over a permutation.
+		/// </summary>
+		/// <param name="permutation"> The permutation to visit. </param>
+		/// <param name="position"> The position within the permutation this iterator refers to. </param>
+		explicit PermutationIterator(RandomPermutation permutation = RandomPermutation(), std::uint64_t position = 0) :
+			m_permutation(permutation),
+			m_position(position)
+		{
+		}
+
+		/// <summary>
+		/// Gets the position within the permutation this iterator refers to.
+		/// </summary>
+		[[nodiscard]]
+		std::uint64_t position() const
+		{
+			return m_position;
+		}
+
+		/// <summary>
+		/// Gets the permuted index at the current position.
+		/// </summary>
+		/// <return> The permuted index. </return>
+		[[nodiscard]]
+		reference operator*() const
+		{
+			return m_permutation(m_position);
+		}
+
+		/// <summary>
+		/// Gets the permuted index n steps forward from the current position.
+		/// </summary>
+		[[nodiscard]]
+		reference operator[](difference_type n) const
+		{
+			return m_permutation(m_position + static_cast<std::uint64_t>(n));
+		}
+
+		/// <summary>
+		/// Moves the iterator forward.
+		/// </summary>
+		PermutationIterator& operator++()
+		{
+			++m_position;
+			return *this;
+		}
+
+		/// <summary>
+		/// Moves the iterator forward.
+		/// Returns an iterator at the original position.
+		/// </summary>
+		[[nodiscard]]
+		PermutationIterator operator++(int)
+		{
+			PermutationIterator out(*this);
+			++(*this);
+			return out;
+		}
+
+		/// <summary>
+		/// Moves the iterator backward.
+		/// </summary>
+		PermutationIterator& operator--()
+		{
+			--m_position;
+			return *this;
+		}
+
+		/// <summary>
+		/// Moves the iterator backward.
+		/// Returns an iterator at the original position.
+		/// </summary>
+		[[nodiscard]]
+		PermutationIterator operator--(int)
+		{
+			PermutationIterator out(*this);
+			--(*this);
+			return out;
+		}
+
+		/// <summary>
+		/// Moves the iterator forward n steps.
+		/// </summary>
+		PermutationIterator& operator+=(difference_type n)
+		{
+			m_position += static_cast<std::uint64_t>(n);
+			return *this;
+		}
+
+		/// <summary>
+		/// Moves the iterator backward n steps.
+		/// </summary>
+		PermutationIterator& operator-=(difference_type n)
+		{
+			m_position -= static_cast<std::uint64_t>(n);
+			return *this;
+		}
+
+		/// <summary>
+		/// Returns a new iterator n steps forward from this one.
+		/// </summary>
+		[[nodiscard]]
+		PermutationIterator operator+(difference_type n) const
+		{
+			PermutationIterator out(*this);
+			out += n;
+			return out;
+		}
+
+		/// <summary>
+		/// Returns a new iterator lhs steps forward from rhs.
+		/// </summary>
+		[[nodiscard]]
+		friend PermutationIterator operator+(difference_type lhs, const PermutationIterator& rhs)
+		{
+			return rhs + lhs;
+		}
+
+		/// <summary>
+		/// Returns a new iterator n steps backward from this one.
+		/// </summary>
+		[[nodiscard]]
+		PermutationIterator operator-(difference_type n) const
+		{
+			PermutationIterator out(*this);
+			out -= n;
+			return out;
+		}
+
+		/// <summary>
+		/// Returns the number of steps from rhs to lhs.
+		/// </summary>
+		[[nodiscard]]
+		friend difference_type operator-(const PermutationIterator& lhs, const PermutationIterator& rhs)
+		{
+			return static_cast<difference_type>(lhs.m_position - rhs.m_position);
+		}
+
+		/// <summary>
+		/// Compare iterators for equality of position.
+		/// </summary>
+		[[nodiscard]]
+		friend bool operator==(const PermutationIterator& lhs, const PermutationIterator& rhs)
+		{
+			return lhs.m_position == rhs.m_position;
+		}
+
+		/// <summary>
+		/// Compare iterators for inequality of position.
+		/// </summary>
+		[[nodiscard]]
+		friend bool operator!=(const PermutationIterator& lhs, const PermutationIterator& rhs)
+		{
+			return lhs.m_position != rhs.m_position;
+		}
+
+		/// <summary>
+		/// Orders iterators by position.
+		/// </summary>
+		[[nodiscard]]
+		friend bool operator<(const PermutationIterator& lhs, const PermutationIterator& rhs)
+		{
+			return lhs.m_position < rhs.m_position;
+		}
+
+		/// <summary>
+		/// Orders iterators by position.
+		/// </summary>
+		[[nodiscard]]
+		friend bool operator>(const PermutationIterator& lhs, const PermutationIterator& rhs)
+		{
+			return rhs < lhs;
+		}
+
+		/// <summary>
+		/// Orders iterators by position.
+		/// </summary>
+		[[nodiscard]]
+		friend bool operator<=(const PermutationIterator& lhs, const PermutationIterator& rhs)
+		{
+			return !(rhs < lhs);
+		}
+
+		/// <summary>
+		/// Orders iterators by position.
+		/// </summary>
+		[[nodiscard]]
+		friend bool operator>=(const PermutationIterator& lhs, const PermutationIterator& rhs)
+		{
+			return !(lhs < rhs);
+		}
+
+	private:
+		RandomPermutation m_permutation;
+		std::uint64_t m_position;
+	};
+
+	/// <summary>
+	/// Gets the first iterator over a permutation.
+	/// </summary>
+	[[nodiscard]]
+	inline PermutationIterator begin(const RandomPermutation& permutation)
+	{
+		return PermutationIterator(permutation, 0);
+	}
+
+	/// <summary>
+	/// Gets the iterator one past the last position of a permutation.
+	/// </summary>
+	[[nodiscard]]
+	inline PermutationIterator end(const RandomPermutation& permutation)
+	{
+		return PermutationIterator(permutation, permutation.size());
+	}
+}
\ No newline at end of file
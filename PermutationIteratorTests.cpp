@@ -0,0 +1,69 @@
+﻿#include "catch2/catch.hpp"
+#include "PermutationIterator.h"
+#include "TransformIterator.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <numeric>
+#include <vector>
+
+TEST_CASE("RandomPermutation is a bijection", "[PermutationIterator]")
+{
+	for (std::uint64_t size : { 1, 2, 3, 4, 5, 17, 100, 1000, 4096, 10007 })
+	{
+		lagy::RandomPermutation permutation(size, 42);
+		std::vector<bool> seen(size, false);
+		for (std::uint64_t i = 0; i < size; ++i)
+		{
+			const std::uint64_t index = permutation(i);
+			REQUIRE(index < size);
+			REQUIRE(!seen[index]);
+			seen[index] = true;
+		}
+	}
+}
+
+TEST_CASE("PermutationIterator visits an index space in pseudo-random order", "[PermutationIterator]")
+{
+	constexpr std::uint64_t size = 5000;
+	lagy::RandomPermutation permutation(size, 0xfeedull);
+
+	std::vector<std::uint64_t> order(begin(permutation), end(permutation));
+	REQUIRE(order.size() == size);
+
+	SECTION("The order is shuffled and keyed")
+	{
+		std::vector<std::uint64_t> identity(size);
+		std::iota(identity.begin(), identity.end(), 0);
+		REQUIRE(order != identity);
+
+		lagy::RandomPermutation otherKey(size, 0xbeefull);
+		REQUIRE(std::vector<std::uint64_t>(begin(otherKey), end(otherKey)) != order);
+
+		std::sort(order.begin(), order.end());
+		REQUIRE(order == identity);
+	}
+
+	SECTION("Random access agrees with sequential iteration")
+	{
+		auto first = begin(permutation);
+		REQUIRE(end(permutation) - first == static_cast<std::ptrdiff_t>(size));
+		for (std::ptrdiff_t i : { 0, 1, 2500, 4999 })
+		{
+			REQUIRE(first[i] == order[i]);
+			REQUIRE(*(first + i) == order[i]);
+		}
+	}
+
+	SECTION("PermutationIterator can index a container through a TransformIterator")
+	{
+		std::vector<int> values(size);
+		std::iota(values.begin(), values.end(), 0);
+		auto lookup = [&values](const lagy::PermutationIterator& it) -> int& { return values[*it]; };
+
+		lagy::TransformIterator shuffledBegin(begin(permutation), lookup);
+		lagy::TransformIterator shuffledEnd(end(permutation), lookup);
+		REQUIRE(std::accumulate(shuffledBegin, shuffledEnd, std::int64_t{ 0 }) == std::int64_t{ size } * (size - 1) / 2);
+		REQUIRE(shuffledBegin[10] == static_cast<int>(order[10]));
+	}
+}
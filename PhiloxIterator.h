@@ -0,0 +1,368 @@
+﻿#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+
+namespace lagy {
+
+	/// <summary>
+	/// The Philox4x32-10 counter-based random number generator.
+	/// Every block of four 32 bit values is a pure function of a 128 bit counter and a 64 bit key,
+	/// so any part of the stream can be generated without generating what comes before it.
+	/// </summary>
+	struct Philox4x32
+	{
+		using Block = std::array<std::uint32_t, 4>;
+
+		/// <summary>
+		/// The number of values produced per counter.
+		/// </summary>
+		static constexpr std::size_t blockSize = 4;
+
+		/// <summary>
+		/// Generates the block of random values for a counter.
+		/// </summary>
+		/// <param name="counter"> The counter. </param>
+		/// <param name="key"> The key. </param>
+		/// <return> The four random values for the counter. </return>
+		[[nodiscard]]
+		static constexpr Block generate(Block counter, std::array<std::uint32_t, 2> key)
+		{
+			for (int round = 0; round < 10; ++round)
+			{
+				if (round != 0)
+				{
+					key[0] += 0x9E3779B9u;
+					key[1] += 0xBB67AE85u;
+				}
+
+				const std::uint64_t product0 = std::uint64_t{ 0xD2511F53u } * counter[0];
+				const std::uint64_t product1 = std::uint64_t{ 0xCD9E8D57u } * counter[2];
+				counter = {
+					static_cast<std::uint32_t>(product1 >> 32) ^ counter[1] ^ key[0],
+					static_cast<std::uint32_t>(product1),
+					static_cast<std::uint32_t>(product0 >> 32) ^ counter[3] ^ key[1],
+					static_cast<std::uint32_t>(product0)
+				};
+			}
+			return counter;
+		}
+
+		/// <summary>
+		/// Generates the block of random values at a block index of a stream.
+		/// </summary>
+		/// <param name="key"> The key. </param>
+		/// <param name="stream"> The stream, selecting one of 2^64 independent sequences per key. </param>
+		/// <param name="blockIndex"> The index of the block within the stream. </param>
+		/// <return> The four random values of the block. </return>
+		[[nodiscard]]
+		static constexpr Block generate(std::uint64_t key, std::uint64_t stream, std::uint64_t blockIndex)
+		{
+			return generate(
+				{ static_cast<std::uint32_t>(blockIndex), static_cast<std::uint32_t>(blockIndex >> 32),
+				  static_cast<std::uint32_t>(stream), static_cast<std::uint32_t>(stream >> 32) },
+				{ static_cast<std::uint32_t>(key), static_cast<std::uint32_t>(key >> 32) });
+		}
+
+		/// <summary>
+		/// Writes count consecutive values of a stream, starting at position, to out.
+		/// Whole blocks are generated several at a time in independent lanes so the compiler can vectorize them.
+		/// </summary>
+		/// <param name="key"> The key. </param>
+		/// <param name="stream"> The stream. </param>
+		/// <param name="position"> The index of the first value within the stream. </param>
+		/// <param name="out"> The output. </param>
+		/// <param name="count"> The number of values to write. </param>
+		static void fill(std::uint64_t key, std::uint64_t stream, std::uint64_t position, std::uint32_t* out, std::size_t count)
+		{
+			// leading values of a partially consumed block
+			while (count != 0 && position % blockSize != 0)
+			{
+				*out++ = generate(key, stream, position / blockSize)[position % blockSize];
+				++position;
+				--count;
+			}
+
+			constexpr std::size_t lanes = 8;
+			std::uint64_t blockIndex = position / blockSize;
+			for (; count >= lanes * blockSize; count -= lanes * blockSize, blockIndex += lanes)
+			{
+				Block blocks[lanes];
+				for (std::size_t lane = 0; lane < lanes; ++lane)
+				{
+					blocks[lane] = generate(key, stream, blockIndex + lane);
+				}
+				for (std::size_t lane = 0; lane < lanes; ++lane)
+				{
+					for (std::size_t i = 0; i < blockSize; ++i)
+					{
+						*out++ = blocks[lane][i];
+					}
+				}
+			}
+
+			for (std::size_t i = 0; i < count; ++i)
+			{
+				*out++ = generate(key, stream, blockIndex + i / blockSize)[i % blockSize];
+			}
+		}
+	};
+
+	/// <summary>
+	/// A random access iterator over the values of a Philox4x32 stream.
+	/// The value at position i is computed directly from (key, stream, i), so any split of a range of
+	/// PhiloxIterators yields the same values no matter how it is partitioned between threads.
+	///
+	/// Dereferencing returns values rather than references. Iterators compare by position only.
+	/// </summary>
+	class PhiloxIterator
+	{
+	public:
+
+		// std::iterator_traits types
+		using value_type = std::uint32_t;
+		using difference_type = std::ptrdiff_t;
+		using pointer = const std::uint32_t*;
+		using reference = std::uint32_t;
+		using iterator_category = std::random_access_iterator_tag;
+
+		/// <summary>
+		/// Constructor:
+		/// Creates an iterator over the values of the stream selected by key and stream.
+		/// </summary>
+		/// <param name="key"> The key. </param>
+		/// <param name="stream"> The stream. </param>
+		/// <param name="position"> The index of the value this iterator refers to. </param>
+		explicit PhiloxIterator(std::uint64_t key = 0, std::uint64_t stream = 0, std::uint64_t position = 0) :
+			m_key(key),
+			m_stream(stream),
+			m_position(position),
+			m_cachedBlockIndex(position / Philox4x32::blockSize),
+			m_cachedBlock(Philox4x32::generate(key, stream, m_cachedBlockIndex))
+		{
+		}
+
+		/// <summary>
+		/// Gets the index of the value this iterator refers to.
+		/// </summary>
+		[[nodiscard]]
+		std::uint64_t position() const
+		{
+			return m_position;
+		}
+
+		/// <summary>
+		/// Gets the random value at the current position.
+		/// The block holding it is generated when the iterator moves into it, so sequential access runs the
+		/// generator once per four values and dereferencing is a plain read, safe from several threads at once.
+		/// </summary>
+		/// <return> The random value at the current position. </return>
+		[[nodiscard]]
+		reference operator*() const
+		{
+			return m_cachedBlock[m_position % Philox4x32::blockSize];
+		}
+
+		/// <summary>
+		/// Generate the random value n steps forward from the current position.
+		/// </summary>
+		[[nodiscard]]
+		reference operator[](difference_type n) const
+		{
+			return *(*this + n);
+		}
+
+		/// <summary>
+		/// Moves the iterator forward.
+		/// </summary>
+		PhiloxIterator& operator++()
+		{
+			++m_position;
+			refresh();
+			return *this;
+		}
+
+		/// <summary>
+		/// Moves the iterator forward.
+		/// Returns an iterator at the original position.
+		/// </summary>
+		[[nodiscard]]
+		PhiloxIterator operator++(int)
+		{
+			PhiloxIterator out(*this);
+			++(*this);
+			return out;
+		}
+
+		/// <summary>
+		/// Moves the iterator backward.
+		/// </summary>
+		PhiloxIterator& operator--()
+		{
+			--m_position;
+			refresh();
+			return *this;
+		}
+
+		/// <summary>
+		/// Moves the iterator backward.
+		/// Returns an iterator at the original position.
+		/// </summary>
+		[[nodiscard]]
+		PhiloxIterator operator--(int)
+		{
+			PhiloxIterator out(*this);
+			--(*this);
+			return out;
+		}
+
+		/// <summary>
+		/// Moves the iterator forward n steps.
+		/// </summary>
+		PhiloxIterator& operator+=(difference_type n)
+		{
+			m_position += static_cast<std::uint64_t>(n);
+			refresh();
+			return *this;
+		}
+
+		/// <summary>
+		/// Moves the iterator backward n steps.
+		/// </summary>
+		PhiloxIterator& operator-=(difference_type n)
+		{
+			m_position -= static_cast<std::uint64_t>(n);
+			refresh();
+			return *this;
+		}
+
+		/// <summary>
+		/// Returns a new iterator n steps forward from this one.
+		/// </summary>
+		[[nodiscard]]
+		PhiloxIterator operator+(difference_type n) const
+		{
+			PhiloxIterator out(*this);
+			out += n;
+			return out;
+		}
+
+		/// <summary>
+		/// Returns a new iterator lhs steps forward from rhs.
+		/// </summary>
+		[[nodiscard]]
+		friend PhiloxIterator operator+(difference_type lhs, const PhiloxIterator& rhs)
+		{
+			return rhs + lhs;
+		}
+
+		/// <summary>
+		/// Returns a new iterator n steps backward from this one.
+		/// </summary>
+		[[nodiscard]]
+		PhiloxIterator operator-(difference_type n) const
+		{
+			PhiloxIterator out(*this);
+			out -= n;
+			return out;
+		}
+
+		/// <summary>
+		/// Returns the number of steps from rhs to lhs.
+		/// </summary>
+		[[nodiscard]]
+		friend difference_type operator-(const PhiloxIterator& lhs, const PhiloxIterator& rhs)
+		{
+			return static_cast<difference_type>(lhs.m_position - rhs.m_position);
+		}
+
+		/// <summary>
+		/// Compare iterators for equality of position.
+		/// </summary>
+		[[nodiscard]]
+		friend bool operator==(const PhiloxIterator& lhs, const PhiloxIterator& rhs)
+		{
+			return lhs.m_position == rhs.m_position;
+		}
+
+		/// <summary>
+		/// Compare iterators for inequality of position.
+		/// </summary>
+		[[nodiscard]]
+		friend bool operator!=(const PhiloxIterator& lhs, const PhiloxIterator& rhs)
+		{
+			return lhs.m_position != rhs.m_position;
+		}
+
+		/// <summary>
+		/// Orders iterators by position.
+		/// </summary>
+		[[nodiscard]]
+		friend bool operator<(const PhiloxIterator& lhs, const PhiloxIterator& rhs)
+		{
+			return lhs.m_position < rhs.m_position;
+		}
+
+		/// <summary>
+		/// Orders iterators by position.
+		/// </summary>
+		[[nodiscard]]
+		friend bool operator>(const PhiloxIterator& lhs, const PhiloxIterator& rhs)
+		{
+			return rhs < lhs;
+		}
+
+		/// <summary>
+		/// Orders iterators by position.
+		/// </summary>
+		[[nodiscard]]
+		friend bool operator<=(const PhiloxIterator& lhs, const PhiloxIterator& rhs)
+		{
+			return !(rhs < lhs);
+		}
+
+		/// <summary>
+		/// Orders iterators by position.
+		/// </summary>
+		[[nodiscard]]
+		friend bool operator>=(const PhiloxIterator& lhs, const PhiloxIterator& rhs)
+		{
+			return !(lhs < rhs);
+		}
+
+		/// <summary>
+		/// Writes the values of [first, last) to out using batch generation.
+		/// Both iterators must refer to the same stream.
+		/// </summary>
+		/// <param name="first"> The first position to generate. </param>
+		/// <param name="last"> The end of the positions to generate. </param>
+		/// <param name="out"> The output. </param>
+		/// <return> The end of the output. </return>
+		friend std::uint32_t* fill(const PhiloxIterator& first, const PhiloxIterator& last, std::uint32_t* out)
+		{
+			const auto count = static_cast<std::size_t>(last - first);
+			Philox4x32::fill(first.m_key, first.m_stream, first.m_position, out, count);
+			return out + count;
+		}
+
+	private:
+
+		void refresh()
+		{
+			const std::uint64_t blockIndex = m_position / Philox4x32::blockSize;
+			if (blockIndex != m_cachedBlockIndex)
+			{
+				m_cachedBlock = Philox4x32::generate(m_key, m_stream, blockIndex);
+				m_cachedBlockIndex = blockIndex;
+			}
+		}
+
+		std::uint64_t m_key;
+		std::uint64_t m_stream;
+		std::uint64_t m_position;
+		std::uint64_t m_cachedBlockIndex;
+		Philox4x32::Block m_cachedBlock;
+	};
+}
\ No newline at end of file
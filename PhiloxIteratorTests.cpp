@@ -0,0 +1,87 @@
+﻿#include "catch2/catch.hpp"
+#include "PhiloxIterator.h"
+#include "TransformIterator.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+TEST_CASE("Philox4x32 matches the reference implementation", "[PhiloxIterator]")
+{
+	SECTION("Zero counter and key")
+	{
+		const auto block = lagy::Philox4x32::generate({ 0, 0, 0, 0 }, { 0, 0 });
+		REQUIRE(block == lagy::Philox4x32::Block{ 0x6627e8d5u, 0xe169c58du, 0xbc57ac4cu, 0x9b00dbd8u });
+	}
+
+	SECTION("Saturated counter and key")
+	{
+		const auto block = lagy::Philox4x32::generate({ 0xffffffffu, 0xffffffffu, 0xffffffffu, 0xffffffffu }, { 0xffffffffu, 0xffffffffu });
+		REQUIRE(block == lagy::Philox4x32::Block{ 0x408f276du, 0x41c83b0eu, 0xa20bc7c6u, 0x6d5451fdu });
+	}
+}
+
+TEST_CASE("PhiloxIterator provides random access to a random stream", "[PhiloxIterator]")
+{
+	constexpr std::uint64_t key = 0x0123456789abcdefull;
+	lagy::PhiloxIterator begin(key, 7);
+	lagy::PhiloxIterator end(key, 7, 1000);
+
+	std::vector<std::uint32_t> sequential(begin, end);
+	REQUIRE(sequential.size() == 1000);
+
+	SECTION("Random access agrees with sequential iteration")
+	{
+		for (std::ptrdiff_t i : { 999, 0, 513, 4, 3, 998 })
+		{
+			REQUIRE(begin[i] == sequential[i]);
+			REQUIRE(*(end - (1000 - i)) == sequential[i]);
+		}
+	}
+
+	SECTION("Streams and keys select different sequences")
+	{
+		std::vector<std::uint32_t> otherStream(lagy::PhiloxIterator(key, 8), lagy::PhiloxIterator(key, 8, 1000));
+		std::vector<std::uint32_t> otherKey(lagy::PhiloxIterator(key + 1, 7), lagy::PhiloxIterator(key + 1, 7, 1000));
+		REQUIRE(otherStream != sequential);
+		REQUIRE(otherKey != sequential);
+	}
+
+	SECTION("Batch generation matches the iterator for any alignment")
+	{
+		for (std::ptrdiff_t offset : { 0, 1, 2, 3, 5 })
+		{
+			std::vector<std::uint32_t> batch(1000 - offset);
+			std::uint32_t* out = fill(begin + offset, end, batch.data());
+			REQUIRE(out == batch.data() + batch.size());
+			REQUIRE(std::equal(batch.begin(), batch.end(), sequential.begin() + offset));
+		}
+	}
+
+	SECTION("PhiloxIterator can be wrapped by a TransformIterator")
+	{
+		auto toUnit = [](const lagy::PhiloxIterator& it) { return *it * (1.0 / 4294967296.0); };
+		lagy::TransformIterator unitBegin(begin, toUnit);
+		lagy::TransformIterator unitEnd(end, toUnit);
+
+		REQUIRE(std::all_of(unitBegin, unitEnd, [](double value) { return value >= 0.0 && value < 1.0; }));
+		REQUIRE(*(unitBegin + 500) == sequential[500] * (1.0 / 4294967296.0));
+	}
+
+	SECTION("A shared iterator can be dereferenced from several threads")
+	{
+		const lagy::PhiloxIterator shared = begin + 513;
+		std::vector<std::uint32_t> seen(4);
+		std::vector<std::thread> threads;
+		for (std::size_t t = 0; t < seen.size(); ++t)
+		{
+			threads.emplace_back([&shared, &seen, t]() { seen[t] = *shared; });
+		}
+		for (std::thread& thread : threads)
+		{
+			thread.join();
+		}
+		REQUIRE(std::all_of(seen.begin(), seen.end(), [&](std::uint32_t value) { return value == sequential[513]; }));
+	}
+}
@@ -0,0 +1,407 @@
+﻿#pragma once
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace lagy {
+
+	/// <summary>
+	/// How the items passing through a pipeline stage are scheduled.
+	/// </summary>
+	enum class StageMode
+	{
+		/// <summary>
+		/// Items are processed concurrently, in any order, by several threads.
+		/// </summary>
+		Parallel,
+
+		/// <summary>
+		/// Items are processed one at a time, in input order, by a single thread.
+		/// </summary>
+		SerialInOrder
+	};
+
+	/// <summary>
+	/// A stage of a pipeline: an operation applied to every item and the mode it is scheduled with.
+	/// Unlike the UnaryOperation of a TransformIterator, the operation is applied to the value produced
+	/// by the previous stage rather than to an iterator.
+	/// </summary>
+	template <class UnaryOperation>
+	struct PipelineStage
+	{
+		using Operation = UnaryOperation;
+
+		StageMode mode;
+		UnaryOperation operation;
+	};
+
+	/// <summary>
+	/// Creates a stage that processes items concurrently.
+	/// </summary>
+	template <class UnaryOperation>
+	[[nodiscard]]
+	PipelineStage<UnaryOperation> parallelStage(UnaryOperation operation)
+	{
+		return { StageMode::Parallel, std::move(operation) };
+	}
+
+	/// <summary>
+	/// Creates a stage that processes items one at a time in input order.
+	/// </summary>
+	template <class UnaryOperation>
+	[[nodiscard]]
+	PipelineStage<UnaryOperation> serialStage(UnaryOperation operation)
+	{
+		return { StageMode::SerialInOrder, std::move(operation) };
+	}
+
+	namespace Detail
+	{
+		/// <summary>
+		/// Limits the number of items in flight in a pipeline.
+		/// </summary>
+		class PipelineTokens
+		{
+		public:
+			explicit PipelineTokens(std::size_t count) :
+				m_available(count)
+			{
+			}
+
+			/// <summary>
+			/// Waits for a token. Returns false if the pipeline was cancelled.
+			/// </summary>
+			bool acquire()
+			{
+				std::unique_lock lock(m_mutex);
+				m_changed.wait(lock, [this]() { return m_available != 0 || m_cancelled; });
+				if (m_cancelled)
+				{
+					return false;
+				}
+				--m_available;
+				return true;
+			}
+
+			void release()
+			{
+				{
+					std::lock_guard lock(m_mutex);
+					++m_available;
+				}
+				m_changed.notify_one();
+			}
+
+			void cancel()
+			{
+				{
+					std::lock_guard lock(m_mutex);
+					m_cancelled = true;
+				}
+				m_changed.notify_all();
+			}
+
+		private:
+			std::mutex m_mutex;
+			std::condition_variable m_changed;
+			std::size_t m_available;
+			bool m_cancelled = false;
+		};
+
+		/// <summary>
+		/// The queue of items waiting for a pipeline stage.
+		/// Ordered queues act as a reorder buffer and release items strictly by sequence number;
+		/// unordered queues release items in arrival order.
+		/// </summary>
+		template <class T>
+		class PipelineQueue
+		{
+		public:
+			using Item = std::pair<std::size_t, T>;
+
+			void configure(bool ordered, std::size_t producerCount)
+			{
+				m_ordered = ordered;
+				m_producers = producerCount;
+			}
+
+			void push(std::size_t sequence, T value)
+			{
+				{
+					std::lock_guard lock(m_mutex);
+					if (m_ordered)
+					{
+						m_pending.emplace(sequence, std::move(value));
+					}
+					else
+					{
+						m_fifo.emplace_back(sequence, std::move(value));
+					}
+				}
+				m_ordered ? m_changed.notify_all() : m_changed.notify_one();
+			}
+
+			/// <summary>
+			/// Waits for the next item. Returns nothing once every producer is done and the queue is drained,
+			/// or when the pipeline is cancelled.
+			/// </summary>
+			std::optional<Item> pop()
+			{
+				std::unique_lock lock(m_mutex);
+				m_changed.wait(lock, [this]() { return m_cancelled || ready() || (m_producers == 0 && empty()); });
+				if (m_cancelled || !ready())
+				{
+					return std::nullopt;
+				}
+
+				if (m_ordered)
+				{
+					auto node = m_pending.extract(m_pending.begin());
+					++m_nextSequence;
+					return Item(node.key(), std::move(node.mapped()));
+				}
+
+				Item item = std::move(m_fifo.front());
+				m_fifo.pop_front();
+				return item;
+			}
+
+			void producerDone()
+			{
+				{
+					std::lock_guard lock(m_mutex);
+					--m_producers;
+				}
+				m_changed.notify_all();
+			}
+
+			void cancel()
+			{
+				{
+					std::lock_guard lock(m_mutex);
+					m_cancelled = true;
+				}
+				m_changed.notify_all();
+			}
+
+		private:
+
+			[[nodiscard]]
+			bool ready() const
+			{
+				return m_ordered ? (!m_pending.empty() && m_pending.begin()->first == m_nextSequence) : !m_fifo.empty();
+			}
+
+			[[nodiscard]]
+			bool empty() const
+			{
+				return m_pending.empty() && m_fifo.empty();
+			}
+
+			std::mutex m_mutex;
+			std::condition_variable m_changed;
+			std::deque<Item> m_fifo;
+			std::map<std::size_t, T> m_pending;
+			std::size_t m_nextSequence = 0;
+			std::size_t m_producers = 0;
+			bool m_ordered = false;
+			bool m_cancelled = false;
+		};
+
+		/// <summary>
+		/// Computes the queue types between the stages of a pipeline whose input items have type T.
+		/// </summary>
+		template <class T, class... Stages>
+		struct PipelineQueues
+		{
+			using type = std::tuple<PipelineQueue<T>>;
+		};
+
+		template <class T, class Stage, class... Rest>
+		struct PipelineQueues<T, Stage, Rest...>
+		{
+			using Next = std::decay_t<std::invoke_result_t<const typename Stage::Operation&, T&&>>;
+			using type = decltype(std::tuple_cat(std::declval<std::tuple<PipelineQueue<T>>>(), std::declval<typename PipelineQueues<Next, Rest...>::type>()));
+		};
+
+		/// <summary>
+		/// Shared state of a running pipeline.
+		/// </summary>
+		template <class Queues>
+		class PipelineRun
+		{
+		public:
+			explicit PipelineRun(std::size_t maxTokens) :
+				tokens(maxTokens)
+			{
+			}
+
+			~PipelineRun()
+			{
+				if (!threads.empty())
+				{
+					fail(nullptr);
+				}
+				for (std::thread& thread : threads)
+				{
+					thread.join();
+				}
+			}
+
+			/// <summary>
+			/// Records the first failure and releases every waiting thread.
+			/// </summary>
+			void fail(std::exception_ptr error)
+			{
+				{
+					std::lock_guard lock(errorMutex);
+					if (!firstError)
+					{
+						firstError = error;
+					}
+				}
+				tokens.cancel();
+				std::apply([](auto&... queue) { (queue.cancel(), ...); }, queues);
+			}
+
+			PipelineTokens tokens;
+			Queues queues;
+			std::vector<std::thread> threads;
+			std::mutex errorMutex;
+			std::exception_ptr firstError;
+		};
+
+		template <std::size_t Index, class Run, class Stages>
+		void launchPipelineStage(Run& run, const Stages& stages, std::size_t parallelThreads)
+		{
+			const auto& stage = std::get<Index>(stages);
+			auto& input = std::get<Index>(run.queues);
+			auto& output = std::get<Index + 1>(run.queues);
+			const std::size_t workers = stage.mode == StageMode::Parallel ? parallelThreads : 1;
+
+			for (std::size_t i = 0; i < workers; ++i)
+			{
+				run.threads.emplace_back([&run, &stage, &input, &output]()
+				{
+					try
+					{
+						while (auto item = input.pop())
+						{
+							output.push(item->first, std::invoke(stage.operation, std::move(item->second)));
+						}
+					}
+					catch (...)
+					{
+						run.fail(std::current_exception());
+					}
+					output.producerDone();
+				});
+			}
+		}
+
+		template <class Run, class Stages, std::size_t... Indices>
+		void launchPipelineStages(Run& run, const Stages& stages, std::size_t parallelThreads, std::index_sequence<Indices...>)
+		{
+			const std::size_t workers[] = { (std::get<Indices>(stages).mode == StageMode::Parallel ? parallelThreads : 1)... };
+
+			// a queue is ordered when the stage reading it is serial, and is fed by the reader or the stage before it
+			(std::get<Indices>(run.queues).configure(
+				std::get<Indices>(stages).mode == StageMode::SerialInOrder,
+				Indices == 0 ? 1 : workers[Indices == 0 ? 0 : Indices - 1]), ...);
+			std::get<sizeof...(Indices)>(run.queues).configure(true, workers[sizeof...(Indices) - 1]);
+
+			(launchPipelineStage<Indices>(run, stages, parallelThreads), ...);
+		}
+	}
+
+	/// <summary>
+	/// Runs the items of [first, last) through a sequence of stages and writes the results to out in input order.
+	///
+	/// At most maxTokens items are between being read and being written at any time, which bounds the memory
+	/// held by the reorder buffers in front of serial stages. Parallel stages run on parallelThreads threads each,
+	/// serial stages on one thread each; the input is read on its own thread and the output is written on the
+	/// calling thread. Operations are invoked as const, concurrently for parallel stages.
+	/// If a stage throws, the pipeline is stopped and the first exception is rethrown.
+	/// </summary>
+	/// <param name="first"> The start of the input. </param>
+	/// <param name="last"> The end of the input. </param>
+	/// <param name="out"> The output. </param>
+	/// <param name="maxTokens"> The maximum number of items in flight. </param>
+	/// <param name="parallelThreads"> The number of threads per parallel stage. Zero uses the hardware concurrency. </param>
+	/// <param name="stages"> The stages, created with parallelStage or serialStage, in processing order. </param>
+	/// <return> The end of the output. </return>
+	template <class InputIterator, class OutputIterator, class... Stages>
+	OutputIterator runPipeline(InputIterator first, InputIterator last, OutputIterator out, std::size_t maxTokens, std::size_t parallelThreads, Stages... stages)
+	{
+		using Input = std::decay_t<decltype(*first)>;
+		using Queues = typename Detail::PipelineQueues<Input, Stages...>::type;
+		constexpr std::size_t stageCount = sizeof...(Stages);
+		static_assert(stageCount > 0, "runPipeline must be provided at least one stage.");
+
+		if (parallelThreads == 0)
+		{
+			parallelThreads = std::max(1u, std::thread::hardware_concurrency());
+		}
+
+		const std::tuple<Stages...> stageTuple(std::move(stages)...);
+		Detail::PipelineRun<Queues> run(std::max<std::size_t>(1, maxTokens));
+
+		Detail::launchPipelineStages(run, stageTuple, parallelThreads, std::make_index_sequence<stageCount>());
+
+		run.threads.emplace_back([&run, first = std::move(first), last = std::move(last)]() mutable
+		{
+			auto& input = std::get<0>(run.queues);
+			try
+			{
+				for (std::size_t sequence = 0; first != last && run.tokens.acquire(); ++first, ++sequence)
+				{
+					input.push(sequence, *first);
+				}
+			}
+			catch (...)
+			{
+				run.fail(std::current_exception());
+			}
+			input.producerDone();
+		});
+
+		auto& results = std::get<stageCount>(run.queues);
+		try
+		{
+			while (auto item = results.pop())
+			{
+				*out = std::move(item->second);
+				++out;
+				run.tokens.release();
+			}
+		}
+		catch (...)
+		{
+			run.fail(std::current_exception());
+		}
+
+		for (std::thread& thread : run.threads)
+		{
+			thread.join();
+		}
+		run.threads.clear();
+
+		if (run.firstError)
+		{
+			std::rethrow_exception(run.firstError);
+		}
+		return out;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,107 @@
+﻿#include "catch2/catch.hpp"
+#include "Pipeline.h"
+#include "TransformIterator.h"
+
+#include <atomic>
+#include <chrono>
+#include <iterator>
+#include <numeric>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+TEST_CASE("runPipeline runs parallel and serial stages and keeps input order", "[Pipeline]")
+{
+	std::vector<int> container(2000);
+	std::iota(container.begin(), container.end(), 0);
+	auto doubled = [](const std::vector<int>::iterator& it) { return *it * 2; };
+	lagy::TransformIterator begin(container.begin(), doubled);
+	lagy::TransformIterator end(container.end(), doubled);
+
+	SECTION("Results are written in input order even when parallel stages finish out of order")
+	{
+		std::vector<std::string> results;
+		lagy::runPipeline(begin, end, std::back_inserter(results), 16, 4,
+			lagy::parallelStage([](int value)
+			{
+				// later items finish sooner so the parallel stage completes out of order
+				std::this_thread::sleep_for(std::chrono::microseconds((7 - value % 8) * 10));
+				return value + 1;
+			}),
+			lagy::parallelStage([](int value) { return std::to_string(value); }));
+
+		REQUIRE(results.size() == container.size());
+		for (std::size_t i = 0; i < results.size(); ++i)
+		{
+			REQUIRE(results[i] == std::to_string(container[i] * 2 + 1));
+		}
+	}
+
+	SECTION("Serial stages see items one at a time in input order")
+	{
+		std::atomic<int> active = 0;
+		std::vector<int> serialOrder;
+		bool overlapped = false;
+
+		std::vector<int> results;
+		lagy::runPipeline(begin, end, std::back_inserter(results), 8, 3,
+			lagy::parallelStage([](int value) { return value / 2; }),
+			lagy::serialStage([&](int value)
+			{
+				overlapped = overlapped || ++active != 1;
+				serialOrder.push_back(value);
+				--active;
+				return value;
+			}),
+			lagy::parallelStage([](int value) { return -value; }));
+
+		REQUIRE(!overlapped);
+		REQUIRE(serialOrder == container);
+		REQUIRE(results.size() == container.size());
+		REQUIRE(results[1999] == -1999);
+	}
+
+	SECTION("The number of items in flight never exceeds the token count")
+	{
+		std::atomic<int> inFlight = 0;
+		std::atomic<int> maxInFlight = 0;
+		std::vector<int> results;
+
+		auto countedBegin = lagy::TransformIterator(container.begin(), [&](const std::vector<int>::iterator& it)
+		{
+			maxInFlight = std::max(maxInFlight.load(), ++inFlight);
+			return *it;
+		});
+		auto countedEnd = lagy::TransformIterator(container.end(), countedBegin.getTransform());
+
+		struct Output
+		{
+			std::atomic<int>* inFlight;
+			std::vector<int>* results;
+			Output& operator=(int value) { --*inFlight; results->push_back(value); return *this; }
+			Output& operator*() { return *this; }
+			Output& operator++() { return *this; }
+		};
+
+		lagy::runPipeline(countedBegin, countedEnd, Output{ &inFlight, &results }, 4, 4,
+			lagy::parallelStage([](int value) { return value; }));
+		REQUIRE(results == container);
+		REQUIRE(maxInFlight <= 5);
+	}
+
+	SECTION("An exception in a stage stops the pipeline and is rethrown")
+	{
+		std::vector<int> results;
+		REQUIRE_THROWS_AS(lagy::runPipeline(begin, end, std::back_inserter(results), 8, 2,
+			lagy::parallelStage([](int value)
+			{
+				if (value == 1000)
+				{
+					throw std::runtime_error("bad item");
+				}
+				return value;
+			})), std::runtime_error);
+		REQUIRE(results.size() < container.size());
+	}
+}
@@ -0,0 +1,496 @@
+﻿#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <optional>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "TransformIterator.h"
+
+namespace lagy {
+
+	/// <summary>
+	/// A value repeated length times.
+	/// </summary>
+	template <class T>
+	struct Run
+	{
+		T value;
+		std::size_t length;
+	};
+
+	template <class T>
+	class RunLengthIterator;
+
+	/// <summary>
+	/// A run-length encoded sequence, expanded lazily by RunLengthIterator.
+	/// Keeps the offset of the first element of every run so positions can be located by binary search.
+	/// </summary>
+	template <class T>
+	class RunLengthColumn
+	{
+	public:
+
+		/// <summary>
+		/// Constructor:
+		/// Creates a column from its runs. Empty runs are allowed and skipped during iteration.
+		/// </summary>
+		/// <param name="runs"> The runs in order. </param>
+		explicit RunLengthColumn(std::vector<Run<T>> runs) :
+			m_runs(std::move(runs))
+		{
+			m_offsets.reserve(m_runs.size() + 1);
+			std::size_t offset = 0;
+			for (const Run<T>& run : m_runs)
+			{
+				m_offsets.push_back(offset);
+				offset += run.length;
+			}
+			m_offsets.push_back(offset);
+		}
+
+		/// <summary>
+		/// Gets the runs of the column.
+		/// </summary>
+		[[nodiscard]]
+		const std::vector<Run<T>>& runs() const
+		{
+			return m_runs;
+		}
+
+		/// <summary>
+		/// Gets the number of expanded elements.
+		/// </summary>
+		[[nodiscard]]
+		std::size_t size() const
+		{
+			return m_offsets.back();
+		}
+
+		/// <summary>
+		/// Gets the position of the first element of a run. runOffset(runs().size()) is size().
+		/// </summary>
+		[[nodiscard]]
+		std::size_t runOffset(std::size_t run) const
+		{
+			return m_offsets[run];
+		}
+
+		/// <summary>
+		/// Finds the run containing a position, skipping empty runs.
+		/// </summary>
+		[[nodiscard]]
+		std::size_t findRun(std::size_t position) const
+		{
+			return static_cast<std::size_t>(std::upper_bound(m_offsets.begin(), m_offsets.end(), position) - m_offsets.begin()) - 1;
+		}
+
+		/// <summary>
+		/// Gets an iterator at the first expanded element.
+		/// </summary>
+		[[nodiscard]]
+		RunLengthIterator<T> begin() const
+		{
+			return RunLengthIterator<T>(*this, 0);
+		}
+
+		/// <summary>
+		/// Gets an iterator past the last expanded element.
+		/// </summary>
+		[[nodiscard]]
+		RunLengthIterator<T> end() const
+		{
+			return RunLengthIterator<T>(*this, size());
+		}
+
+	private:
+		std::vector<Run<T>> m_runs;
+		std::vector<std::size_t> m_offsets;
+	};
+
+	/// <summary>
+	/// A random access iterator over the expanded elements of a RunLengthColumn.
+	/// Moving within a run is O(1); moving further locates the run by binary search over the run offsets.
+	/// </summary>
+	template <class T>
+	class RunLengthIterator
+	{
+	public:
+
+		// std::iterator_traits types
+		using value_type = T;
+		using difference_type = std::ptrdiff_t;
+		using pointer = const T*;
+		using reference = const T&;
+		using iterator_category = std::random_access_iterator_tag;
+
+		RunLengthIterator() = default;
+
+		/// <summary>
+		/// Constructor:
+		/// Creates an iterator at a position of a column.
+		/// </summary>
+		/// <param name="column"> The column. Must outlive the iterator. </param>
+		/// <param name="position"> The position of the expanded element this iterator refers to. </param>
+		RunLengthIterator(const RunLengthColumn<T>& column, std::size_t position) :
+			m_column(&column),
+			m_position(position),
+			m_run(column.findRun(position))
+		{
+		}
+
+		/// <summary>
+		/// Gets the position of the expanded element this iterator refers to.
+		/// </summary>
+		[[nodiscard]]
+		std::size_t position() const
+		{
+			return m_position;
+		}
+
+		/// <summary>
+		/// Gets the column the iterator walks, or nullptr for a default constructed iterator.
+		/// </summary>
+		[[nodiscard]]
+		const RunLengthColumn<T>* column() const
+		{
+			return m_column;
+		}
+
+		/// <summary>
+		/// Gets the index of the run containing the current element.
+		/// </summary>
+		[[nodiscard]]
+		std::size_t runIndex() const
+		{
+			return m_run;
+		}
+
+		/// <summary>
+		/// Gets the number of elements from the current one to the end of its run.
+		/// </summary>
+		[[nodiscard]]
+		std::size_t remainingInRun() const
+		{
+			return m_column->runOffset(m_run + 1) - m_position;
+		}
+
+		/// <summary>
+		/// Moves the iterator to the first element of the next non-empty run.
+		/// </summary>
+		RunLengthIterator& nextRun()
+		{
+			m_position = m_column->runOffset(m_run + 1);
+			settle();
+			return *this;
+		}
+
+		/// <summary>
+		/// Gets the value of the current element.
+		/// </summary>
+		[[nodiscard]]
+		reference operator*() const
+		{
+			return m_column->runs()[m_run].value;
+		}
+
+		/// <summary>
+		/// Gets the value of the current element.
+		/// </summary>
+		[[nodiscard]]
+		pointer operator->() const
+		{
+			return &**this;
+		}
+
+		/// <summary>
+		/// Gets the value of the element n steps forward from the current one.
+		/// </summary>
+		[[nodiscard]]
+		reference operator[](difference_type n) const
+		{
+			return *(*this + n);
+		}
+
+		/// <summary>
+		/// Moves the iterator forward.
+		/// </summary>
+		RunLengthIterator& operator++()
+		{
+			++m_position;
+			settle();
+			return *this;
+		}
+
+		/// <summary>
+		/// Moves the iterator forward.
+		/// Returns an iterator at the original position.
+		/// </summary>
+		[[nodiscard]]
+		RunLengthIterator operator++(int)
+		{
+			RunLengthIterator out(*this);
+			++(*this);
+			return out;
+		}
+
+		/// <summary>
+		/// Moves the iterator backward.
+		/// </summary>
+		RunLengthIterator& operator--()
+		{
+			return *this -= 1;
+		}
+
+		/// <summary>
+		/// Moves the iterator backward.
+		/// Returns an iterator at the original position.
+		/// </summary>
+		[[nodiscard]]
+		RunLengthIterator operator--(int)
+		{
+			RunLengthIterator out(*this);
+			--(*this);
+			return out;
+		}
+
+		/// <summary>
+		/// Moves the iterator forward n steps.
+		/// </summary>
+		RunLengthIterator& operator+=(difference_type n)
+		{
+			m_position += static_cast<std::size_t>(n);
+			if (m_run >= m_column->runs().size() || m_position < m_column->runOffset(m_run) || m_position >= m_column->runOffset(m_run + 1))
+			{
+				m_run = m_column->findRun(m_position);
+			}
+			return *this;
+		}
+
+		/// <summary>
+		/// Moves the iterator backward n steps.
+		/// </summary>
+		RunLengthIterator& operator-=(difference_type n)
+		{
+			return *this += -n;
+		}
+
+		/// <summary>
+		/// Returns a new iterator n steps forward from this one.
+		/// </summary>
+		[[nodiscard]]
+		RunLengthIterator operator+(difference_type n) const
+		{
+			RunLengthIterator out(*this);
+			out += n;
+			return out;
+		}
+
+		/// <summary>
+		/// Returns a new iterator lhs steps forward from rhs.
+		/// </summary>
+		[[nodiscard]]
+		friend RunLengthIterator operator+(difference_type lhs, const RunLengthIterator& rhs)
+		{
+			return rhs + lhs;
+		}
+
+		/// <summary>
+		/// Returns a new iterator n steps backward from this one.
+		/// </summary>
+		[[nodiscard]]
+		RunLengthIterator operator-(difference_type n) const
+		{
+			RunLengthIterator out(*this);
+			out -= n;
+			return out;
+		}
+
+		/// <summary>
+		/// Returns the number of steps from rhs to lhs.
+		/// </summary>
+		[[nodiscard]]
+		friend difference_type operator-(const RunLengthIterator& lhs, const RunLengthIterator& rhs)
+		{
+			return static_cast<difference_type>(lhs.m_position) - static_cast<difference_type>(rhs.m_position);
+		}
+
+		/// <summary>
+		/// Compare iterators for equality of position.
+		/// </summary>
+		[[nodiscard]]
+		friend bool operator==(const RunLengthIterator& lhs, const RunLengthIterator& rhs)
+		{
+			return lhs.m_position == rhs.m_position;
+		}
+
+		/// <summary>
+		/// Compare iterators for inequality of position.
+		/// </summary>
+		[[nodiscard]]
+		friend bool operator!=(const RunLengthIterator& lhs, const RunLengthIterator& rhs)
+		{
+			return lhs.m_position != rhs.m_position;
+		}
+
+		/// <summary>
+		/// Orders iterators by position.
+		/// </summary>
+		[[nodiscard]]
+		friend bool operator<(const RunLengthIterator& lhs, const RunLengthIterator& rhs)
+		{
+			return lhs.m_position < rhs.m_position;
+		}
+
+		/// <summary>
+		/// Orders iterators by position.
+		/// </summary>
+		[[nodiscard]]
+		friend bool operator>(const RunLengthIterator& lhs, const RunLengthIterator& rhs)
+		{
+			return rhs < lhs;
+		}
+
+		/// <summary>
+		/// Orders iterators by position.
+		/// </summary>
+		[[nodiscard]]
+		friend bool operator<=(const RunLengthIterator& lhs, const RunLengthIterator& rhs)
+		{
+			return !(rhs < lhs);
+		}
+
+		/// <summary>
+		/// Orders iterators by position.
+		/// </summary>
+		[[nodiscard]]
+		friend bool operator>=(const RunLengthIterator& lhs, const RunLengthIterator& rhs)
+		{
+			return !(lhs < rhs);
+		}
+
+	private:
+
+		void settle()
+		{
+			// skip forward over the end of the current run and any empty runs after it
+			const std::size_t runCount = m_column->runs().size();
+			while (m_run < runCount && m_position >= m_column->runOffset(m_run + 1))
+			{
+				++m_run;
+			}
+		}
+
+		const RunLengthColumn<T>* m_column = nullptr;
+		std::size_t m_position = 0;
+		std::size_t m_run = 0;
+	};
+
+	/// <summary>
+	/// A UnaryOperation for a TransformIterator over a RunLengthIterator that applies the wrapped operation
+	/// once per run and returns the cached result for the other elements of the run.
+	/// Copies of the transform share one cache, since algorithms freely copy iterators; the cache is not
+	/// synchronized, so threads should each construct their own transform.
+	/// </summary>
+	template <class T, class UnaryOperation>
+	class PerRunTransform
+	{
+	public:
+		using result_type = std::decay_t<std::invoke_result_t<const UnaryOperation&, const RunLengthIterator<T>&>>;
+
+		/// <summary>
+		/// Constructor:
+		/// Wraps the provided operation.
+		/// </summary>
+		/// <param name="operation"> The operation applied to a RunLengthIterator at the first element visited in each run. </param>
+		explicit PerRunTransform(UnaryOperation operation) :
+			m_operation(std::move(operation)),
+			m_cache(std::make_shared<Cache>())
+		{
+		}
+
+		/// <summary>
+		/// Applies the operation if the iterator is in a different run, or a different column, than the cached result.
+		/// </summary>
+		[[nodiscard]]
+		result_type operator()(const RunLengthIterator<T>& it) const
+		{
+			Cache& cache = *m_cache;
+			if (!cache.result || cache.run != it.runIndex() || cache.column != it.column())
+			{
+				cache.result.emplace(std::invoke(m_operation, it));
+				cache.column = it.column();
+				cache.run = it.runIndex();
+			}
+			return *cache.result;
+		}
+
+	private:
+		struct Cache
+		{
+			std::optional<result_type> result;
+			const RunLengthColumn<T>* column = nullptr;
+			std::size_t run = 0;
+		};
+
+		UnaryOperation m_operation;
+		std::shared_ptr<Cache> m_cache;
+	};
+
+	/// <summary>
+	/// Wraps an operation over RunLengthIterators of T so it is evaluated once per run.
+	/// </summary>
+	template <class T, class UnaryOperation>
+	[[nodiscard]]
+	PerRunTransform<T, UnaryOperation> perRun(UnaryOperation operation)
+	{
+		return PerRunTransform<T, UnaryOperation>(std::move(operation));
+	}
+
+	/// <summary>
+	/// Calls consumer(value, count) once per run overlapping [first, last), with count the number of
+	/// elements of the run inside the range. Aggregations over the range cost O(runs) instead of O(elements).
+	/// </summary>
+	/// <param name="first"> The start of the range. </param>
+	/// <param name="last"> The end of the range. </param>
+	/// <param name="consumer"> Called with the value of each run and its number of elements in the range. </param>
+	template <class T, class RunConsumer>
+	void forEachRun(RunLengthIterator<T> first, const RunLengthIterator<T>& last, RunConsumer&& consumer)
+	{
+		while (first < last)
+		{
+			const std::size_t count = std::min<std::size_t>(first.remainingInRun(), static_cast<std::size_t>(last - first));
+			consumer(*first, count);
+			first.nextRun();
+		}
+	}
+
+	/// <summary>
+	/// Calls consumer(transformed value, count) once per run overlapping a range of TransformIterators over
+	/// RunLengthIterators. The transform is evaluated once per run.
+	/// </summary>
+	/// <param name="first"> The start of the range. </param>
+	/// <param name="last"> The end of the range. </param>
+	/// <param name="consumer"> Called with the transformed value of each run and its number of elements in the range. </param>
+	template <class T, class UnaryOperation, class RunConsumer>
+	void forEachRun(
+		const TransformIterator<RunLengthIterator<T>, UnaryOperation>& first,
+		const TransformIterator<RunLengthIterator<T>, UnaryOperation>& last,
+		RunConsumer&& consumer)
+	{
+		const UnaryOperation& transform = first.getTransform();
+		RunLengthIterator<T> it = first.getWrappedIterator();
+		const RunLengthIterator<T>& end = last.getWrappedIterator();
+		while (it < end)
+		{
+			const std::size_t count = std::min<std::size_t>(it.remainingInRun(), static_cast<std::size_t>(end - it));
+			consumer(std::invoke(transform, it), count);
+			it.nextRun();
+		}
+	}
+}
\ No newline at end of file
@@ -0,0 +1,116 @@
+﻿#include "catch2/catch.hpp"
+#include "RunLengthIterator.h"
+#include "TransformIterator.h"
+
+#include <string>
+#include <vector>
+
+namespace
+{
+	using Column = lagy::RunLengthColumn<int>;
+	using ColumnIterator = lagy::RunLengthIterator<int>;
+
+	std::vector<int> expand(const Column& column)
+	{
+		std::vector<int> values;
+		for (const auto& run : column.runs())
+		{
+			values.insert(values.end(), run.length, run.value);
+		}
+		return values;
+	}
+}
+
+TEST_CASE("RunLengthIterator expands runs lazily", "[RunLengthIterator]")
+{
+	const Column column({ { 200, 3 }, { 404, 0 }, { 500, 2 }, { 200, 4 }, { 302, 0 } });
+	const std::vector<int> expanded = expand(column);
+	REQUIRE(column.size() == 9);
+
+	SECTION("Sequential iteration skips empty runs")
+	{
+		REQUIRE(std::vector<int>(column.begin(), column.end()) == expanded);
+	}
+
+	SECTION("Random access locates the run of any position")
+	{
+		ColumnIterator it = column.begin();
+		for (std::ptrdiff_t i : { 8, 0, 4, 3, 5, 2, 7 })
+		{
+			REQUIRE(it[i] == expanded[i]);
+		}
+
+		it += 4;
+		REQUIRE(*it == 500);
+		REQUIRE(it.remainingInRun() == 1);
+		it -= 2;
+		REQUIRE(*it == 200);
+		REQUIRE(column.end() - it == 7);
+	}
+
+	SECTION("Whole runs can be skipped")
+	{
+		ColumnIterator it = column.begin();
+		it.nextRun();
+		REQUIRE(it.position() == 3);
+		REQUIRE(it.runIndex() == 2);
+		it.nextRun().nextRun();
+		REQUIRE(it == column.end());
+	}
+}
+
+TEST_CASE("Run-length columns compose with TransformIterator", "[RunLengthIterator]")
+{
+	const Column column({ { 200, 1000 }, { 500, 10 }, { 200, 5000 } });
+	int evaluations = 0;
+	auto describe = [&evaluations](const ColumnIterator& it)
+	{
+		++evaluations;
+		return *it == 200 ? std::string("ok") : std::string("error");
+	};
+
+	SECTION("A per-run transform is evaluated once per run")
+	{
+		lagy::TransformIterator begin(column.begin(), lagy::perRun<int>(describe));
+		lagy::TransformIterator end(column.end(), lagy::perRun<int>(describe));
+		REQUIRE(std::count(begin, end, std::string("error")) == 10);
+		REQUIRE(evaluations == 3);
+	}
+
+	SECTION("A per-run transform tells the runs of different columns apart")
+	{
+		const Column other({ { 500, 4 }, { 200, 6 } });
+		const auto transform = lagy::perRun<int>(describe);
+		auto statuses = [&transform](const Column& source)
+		{
+			return std::vector<std::string>(lagy::TransformIterator(source.begin(), transform), lagy::TransformIterator(source.end(), transform));
+		};
+
+		const std::vector<std::string> first = statuses(column);
+		const std::vector<std::string> second = statuses(other);
+		REQUIRE(std::count(first.begin(), first.end(), std::string("error")) == 10);
+		REQUIRE(std::count(second.begin(), second.end(), std::string("error")) == 4);
+		REQUIRE(evaluations == 5);
+	}
+
+	SECTION("forEachRun hands whole runs to aggregations")
+	{
+		lagy::TransformIterator begin(column.begin() + 500, describe);
+		lagy::TransformIterator end(column.begin() + 1500, describe);
+
+		std::size_t errors = 0;
+		std::size_t total = 0;
+		lagy::forEachRun(begin, end, [&](const std::string& status, std::size_t count)
+		{
+			total += count;
+			errors += status == "error" ? count : 0;
+		});
+		REQUIRE(total == 1000);
+		REQUIRE(errors == 10);
+		REQUIRE(evaluations == 3);
+
+		long long sum = 0;
+		lagy::forEachRun(column.begin(), column.end(), [&sum](int value, std::size_t count) { sum += static_cast<long long>(value) * count; });
+		REQUIRE(sum == 200ll * 6000 + 500 * 10);
+	}
+}
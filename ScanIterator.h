@@ -0,0 +1,344 @@
+﻿#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <iterator>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace lagy {
+
+	/// <summary>
+	/// An input iterator yielding the inclusive scan of a range: the value at each position is
+	/// operation(accumulator, element), where the accumulator is the value at the previous position
+	/// (or the initial value at the first position).
+	///
+	/// The accumulator is carried inside the iterator rather than captured by a transform, so copies of a
+	/// ScanIterator continue independently. Each element is combined once per iterator that passes it, when the
+	/// iterator is created at it or moved onto it, so dereferencing is a plain read. The iterator is given the end
+	/// of the range so it never dereferences the end.
+	/// </summary>
+	template <class Iterator, class T, class BinaryOperation>
+	class ScanIterator
+	{
+	public:
+
+		using WrappedIteratorType = Iterator;
+
+		// std::iterator_traits types
+		using value_type = T;
+		using difference_type = typename std::iterator_traits<Iterator>::difference_type;
+		using pointer = const T*;
+		using reference = T;
+		using iterator_category = std::input_iterator_tag;
+
+		/// <summary>
+		/// Constructor:
+		/// Creates an iterator at the wrapped position with the accumulator of the preceding elements.
+		/// </summary>
+		/// <param name="wrapped"> The iterator to be wrapped. </param>
+		/// <param name="last"> The end of the wrapped range. </param>
+		/// <param name="accumulator"> The initial value, or the scan value of the element before wrapped. </param>
+		/// <param name="operation"> The operation combining the accumulator with the next element. </param>
+		ScanIterator(Iterator wrapped, Iterator last, T accumulator, BinaryOperation operation) :
+			m_wrappedIt(std::move(wrapped)),
+			m_last(std::move(last)),
+			m_accumulator(std::move(accumulator)),
+			m_operation(std::move(operation)),
+			m_current(combined())
+		{
+		}
+
+		/// <summary>
+		/// Gets the iterator wrapped by this scan iterator
+		/// </summary>
+		[[nodiscard]]
+		const WrappedIteratorType& getWrappedIterator() const
+		{
+			return m_wrappedIt;
+		}
+
+		/// <summary>
+		/// Gets the accumulator of the elements before the current position.
+		/// </summary>
+		[[nodiscard]]
+		const T& accumulator() const
+		{
+			return m_accumulator;
+		}
+
+		/// <summary>
+		/// Gets the scan value at the current position: the accumulator combined with the current element.
+		/// </summary>
+		[[nodiscard]]
+		reference operator*() const
+		{
+			return m_current;
+		}
+
+		/// <summary>
+		/// Moves the iterator forward, folding the current element into the accumulator and combining the next one.
+		/// </summary>
+		ScanIterator& operator++()
+		{
+			m_accumulator = std::move(m_current);
+			++m_wrappedIt;
+			m_current = combined();
+			return *this;
+		}
+
+		/// <summary>
+		/// Moves the iterator forward.
+		/// Returns an iterator at the original position.
+		/// </summary>
+		[[nodiscard]]
+		ScanIterator operator++(int)
+		{
+			ScanIterator out(*this);
+			++(*this);
+			return out;
+		}
+
+		/// <summary>
+		/// Compare scan iterators for equality.
+		/// </summary>
+		/// <return> True if the wrapped iterators are equal. False otherwise. </return>
+		[[nodiscard]]
+		friend bool operator==(const ScanIterator& lhs, const ScanIterator& rhs)
+		{
+			return lhs.m_wrappedIt == rhs.m_wrappedIt;
+		}
+
+		/// <summary>
+		/// Compare scan iterators for inequality.
+		/// </summary>
+		/// <return> True if the wrapped iterators are not equal. False otherwise. </return>
+		[[nodiscard]]
+		friend bool operator!=(const ScanIterator& lhs, const ScanIterator& rhs)
+		{
+			return lhs.m_wrappedIt != rhs.m_wrappedIt;
+		}
+
+	private:
+
+		// the scan value at the current position, or the accumulator at the end of the range
+		[[nodiscard]]
+		T combined() const
+		{
+			return m_wrappedIt == m_last ? m_accumulator : T(std::invoke(m_operation, m_accumulator, *m_wrappedIt));
+		}
+
+		WrappedIteratorType m_wrappedIt;
+		WrappedIteratorType m_last;
+		T m_accumulator;
+		BinaryOperation m_operation;
+		T m_current;
+	};
+
+	/// <summary>
+	/// Records the scan accumulator every interval elements of a random access range so the scan value at
+	/// any position can be computed by folding at most interval elements from the nearest checkpoint.
+	/// </summary>
+	template <class Iterator, class T, class BinaryOperation>
+	class ScanCheckpoints
+	{
+	public:
+		using difference_type = typename std::iterator_traits<Iterator>::difference_type;
+
+		/// <summary>
+		/// Constructor:
+		/// Scans [first, last) once, recording checkpoints.
+		/// </summary>
+		/// <param name="first"> The start of the range. </param>
+		/// <param name="last"> The end of the range. </param>
+		/// <param name="initial"> The initial value of the scan. </param>
+		/// <param name="operation"> The operation combining the accumulator with the next element. </param>
+		/// <param name="interval"> The number of elements between checkpoints. </param>
+		ScanCheckpoints(Iterator first, Iterator last, T initial, BinaryOperation operation, difference_type interval) :
+			m_first(first),
+			m_size(last - first),
+			m_operation(std::move(operation)),
+			m_interval(std::max<difference_type>(1, interval))
+		{
+			m_checkpoints.reserve(static_cast<std::size_t>(m_size / m_interval + 1));
+			T accumulator = std::move(initial);
+			for (difference_type i = 0; i < m_size; ++i, ++first)
+			{
+				if (i % m_interval == 0)
+				{
+					m_checkpoints.push_back(accumulator);
+				}
+				accumulator = std::invoke(m_operation, std::move(accumulator), *first);
+			}
+			if (m_size % m_interval == 0)
+			{
+				m_checkpoints.push_back(accumulator);
+			}
+		}
+
+		/// <summary>
+		/// Gets the number of elements in the range.
+		/// </summary>
+		[[nodiscard]]
+		difference_type size() const
+		{
+			return m_size;
+		}
+
+		/// <summary>
+		/// Creates a ScanIterator at a position of the range, with the accumulator of the elements before it.
+		/// </summary>
+		/// <param name="position"> A position in [0, size]. </param>
+		[[nodiscard]]
+		ScanIterator<Iterator, T, BinaryOperation> iteratorAt(difference_type position) const
+		{
+			const difference_type checkpoint = position / m_interval;
+			Iterator it = m_first + checkpoint * m_interval;
+			T accumulator = m_checkpoints[static_cast<std::size_t>(checkpoint)];
+			for (difference_type i = checkpoint * m_interval; i < position; ++i, ++it)
+			{
+				accumulator = std::invoke(m_operation, std::move(accumulator), *it);
+			}
+			return ScanIterator<Iterator, T, BinaryOperation>(std::move(it), m_first + m_size, std::move(accumulator), m_operation);
+		}
+
+		/// <summary>
+		/// Gets the inclusive scan value at a position.
+		/// </summary>
+		/// <param name="position"> A position in [0, size). </param>
+		[[nodiscard]]
+		T operator[](difference_type position) const
+		{
+			return *iteratorAt(position);
+		}
+
+	private:
+		Iterator m_first;
+		difference_type m_size;
+		BinaryOperation m_operation;
+		difference_type m_interval;
+		std::vector<T> m_checkpoints;
+	};
+
+	/// <summary>
+	/// Writes the inclusive scan of [first, last) to out using several threads.
+	///
+	/// The range is split into one contiguous part per thread. Each part is scanned locally, writing its
+	/// results to out, then every part after the first combines the total of the parts before it into its
+	/// outputs. Each element is dereferenced once; the operation must be associative.
+	/// Both the range and the output must support random access.
+	/// If the operation or a copy throws, every thread is joined and the first exception is rethrown.
+	/// </summary>
+	/// <param name="first"> The start of the range. </param>
+	/// <param name="last"> The end of the range. </param>
+	/// <param name="out"> The start of the output. </param>
+	/// <param name="initial"> The initial value of the scan. </param>
+	/// <param name="operation"> An associative operation. </param>
+	/// <param name="threadCount"> The number of threads. Zero uses the hardware concurrency. </param>
+	/// <return> The end of the output. </return>
+	template <class Iterator, class OutputIterator, class T, class BinaryOperation>
+	OutputIterator parallelInclusiveScan(Iterator first, Iterator last, OutputIterator out, T initial, BinaryOperation operation, std::size_t threadCount = 0)
+	{
+		if (threadCount == 0)
+		{
+			threadCount = std::max(1u, std::thread::hardware_concurrency());
+		}
+
+		const auto size = static_cast<std::size_t>(last - first);
+		threadCount = std::max<std::size_t>(1, std::min(threadCount, size));
+		auto boundary = [size, threadCount](std::size_t part) { return static_cast<std::ptrdiff_t>(size * part / threadCount); };
+
+		// runs body(part) for every part from firstPart on its own thread, then joins them all
+		auto runParts = [threadCount](std::size_t firstPart, auto body)
+		{
+			std::mutex errorMutex;
+			std::exception_ptr firstError;
+			auto guarded = [&errorMutex, &firstError, &body](std::size_t part)
+			{
+				try
+				{
+					body(part);
+				}
+				catch (...)
+				{
+					std::lock_guard lock(errorMutex);
+					if (!firstError)
+					{
+						firstError = std::current_exception();
+					}
+				}
+			};
+
+			std::vector<std::thread> threads;
+			try
+			{
+				for (std::size_t part = firstPart; part < threadCount; ++part)
+				{
+					threads.emplace_back(guarded, part);
+				}
+			}
+			catch (...)
+			{
+				std::lock_guard lock(errorMutex);
+				if (!firstError)
+				{
+					firstError = std::current_exception();
+				}
+			}
+			for (std::thread& thread : threads)
+			{
+				thread.join();
+			}
+
+			if (firstError)
+			{
+				std::rethrow_exception(firstError);
+			}
+		};
+
+		// pass 1: independent scans of each part, the first one seeded with the initial value
+		runParts(0, [&](std::size_t part)
+		{
+			auto it = first + boundary(part);
+			auto end = first + boundary(part + 1);
+			auto output = out + boundary(part);
+			if (it == end)
+			{
+				return;
+			}
+
+			T accumulator = part == 0 ? std::invoke(operation, initial, *it) : T(*it);
+			*output = accumulator;
+			for (++it, ++output; it != end; ++it, ++output)
+			{
+				accumulator = std::invoke(operation, std::move(accumulator), *it);
+				*output = accumulator;
+			}
+		});
+
+		// the offset of each part is the scan value at the end of the part before it
+		std::vector<T> offsets;
+		for (std::size_t part = 1; part < threadCount; ++part)
+		{
+			const T& partTotal = *(out + (boundary(part) - 1));
+			offsets.push_back(part == 1 ? partTotal : std::invoke(operation, offsets.back(), partTotal));
+		}
+
+		// pass 2: combine the offsets into every part after the first
+		runParts(1, [&](std::size_t part)
+		{
+			const T& offset = offsets[part - 1];
+			for (auto output = out + boundary(part), end = out + boundary(part + 1); output != end; ++output)
+			{
+				*output = std::invoke(operation, offset, *output);
+			}
+		});
+
+		return out + static_cast<std::ptrdiff_t>(size);
+	}
+}
\ No newline at end of file
@@ -0,0 +1,159 @@
+﻿#include "catch2/catch.hpp"
+#include "ScanIterator.h"
+#include "TransformIterator.h"
+
+#include <atomic>
+#include <functional>
+#include <numeric>
+#include <stdexcept>
+#include <vector>
+
+TEST_CASE("ScanIterator carries an accumulator through a transformed range", "[ScanIterator]")
+{
+	// delta encoded values
+	std::vector<int> deltas = { 10, 2, -3, 5, 0, 7, -1, 4 };
+	auto widen = [](const std::vector<int>::iterator& it) { return static_cast<long long>(*it); };
+	lagy::TransformIterator begin(deltas.begin(), widen);
+	lagy::TransformIterator end(deltas.end(), widen);
+
+	std::vector<long long> expected(deltas.size());
+	std::partial_sum(deltas.begin(), deltas.end(), expected.begin());
+
+	SECTION("Scanning decodes the deltas")
+	{
+		lagy::ScanIterator scanBegin(begin, end, 0ll, std::plus<>());
+		lagy::ScanIterator scanEnd(end, end, 0ll, std::plus<>());
+		REQUIRE(std::vector<long long>(scanBegin, scanEnd) == expected);
+	}
+
+	SECTION("Copies continue independently")
+	{
+		lagy::ScanIterator scan(begin, end, 100ll, std::plus<>());
+		++scan;
+		auto copy = scan;
+		++scan;
+		REQUIRE(*copy == 112);
+		REQUIRE(*scan == 109);
+		++copy;
+		REQUIRE(*copy == *scan);
+	}
+
+	SECTION("Dereferencing is a plain read")
+	{
+		int calls = 0;
+		auto counted = [&calls](long long accumulator, long long value) { ++calls; return accumulator + value; };
+		const lagy::ScanIterator scan(begin, end, 0ll, counted);
+		REQUIRE(calls == 1);
+		REQUIRE(*scan == 10);
+		REQUIRE(*scan == 10);
+		REQUIRE(calls == 1);
+
+		// the end is never dereferenced
+		lagy::ScanIterator last(end - 1, end, 0ll, counted);
+		++last;
+		REQUIRE(last == lagy::ScanIterator(end, end, 0ll, counted));
+		REQUIRE(calls == 2);
+	}
+
+	SECTION("The accumulator can be any state machine")
+	{
+		// counts sign changes between consecutive values
+		struct State
+		{
+			long long previous;
+			int changes;
+		};
+		auto step = [](State state, long long value)
+		{
+			if ((state.previous < 0) != (value < 0))
+			{
+				++state.changes;
+			}
+			return State{ value, state.changes };
+		};
+
+		lagy::ScanIterator scan(begin, end, State{ 0, 0 }, step);
+		lagy::ScanIterator scanEnd(end, end, State{ 0, 0 }, step);
+		State last{};
+		for (; scan != scanEnd; ++scan)
+		{
+			last = *scan;
+		}
+		REQUIRE(last.changes == 4);
+	}
+
+	SECTION("Checkpoints give random access to scan values")
+	{
+		lagy::ScanCheckpoints checkpoints(begin, end, 0ll, std::plus<>(), 3);
+		REQUIRE(checkpoints.size() == 8);
+		for (std::ptrdiff_t i = 0; i < checkpoints.size(); ++i)
+		{
+			REQUIRE(checkpoints[i] == expected[i]);
+		}
+
+		auto it = checkpoints.iteratorAt(4);
+		REQUIRE(it.accumulator() == expected[3]);
+		REQUIRE(*++it == expected[5]);
+		REQUIRE(checkpoints.iteratorAt(8).getWrappedIterator() == end);
+	}
+}
+
+TEST_CASE("parallelInclusiveScan matches a sequential scan", "[ScanIterator]")
+{
+	std::vector<int> values(10007);
+	std::iota(values.begin(), values.end(), -5000);
+	auto square = [](const std::vector<int>::iterator& it) { return static_cast<long long>(*it) * *it; };
+	lagy::TransformIterator begin(values.begin(), square);
+	lagy::TransformIterator end(values.end(), square);
+
+	std::vector<long long> expected;
+	long long running = 7;
+	for (int value : values)
+	{
+		running += static_cast<long long>(value) * value;
+		expected.push_back(running);
+	}
+
+	for (std::size_t threads : { 1, 2, 3, 8 })
+	{
+		std::vector<long long> output(values.size());
+		auto outEnd = lagy::parallelInclusiveScan(begin, end, output.begin(), 7ll, std::plus<>(), threads);
+		REQUIRE(outEnd == output.end());
+		REQUIRE(output == expected);
+	}
+}
+
+TEST_CASE("parallelInclusiveScan rethrows a failing operation", "[ScanIterator]")
+{
+	std::vector<int> container(10000);
+	std::iota(container.begin(), container.end(), 0);
+	std::vector<long long> out(container.size());
+
+	SECTION("In the local scans")
+	{
+		auto add = [](long long accumulator, int value)
+		{
+			if (value == 7777)
+			{
+				throw std::runtime_error("bad value");
+			}
+			return accumulator + value;
+		};
+		REQUIRE_THROWS_WITH(lagy::parallelInclusiveScan(container.begin(), container.end(), out.begin(), 0ll, add, 4), "bad value");
+	}
+
+	SECTION("In the pass adding the offsets")
+	{
+		// pass 1 makes one call per element and the offsets two more, so later calls are in pass 2
+		std::atomic<int> calls{ 0 };
+		auto add = [&calls](long long accumulator, long long value)
+		{
+			if (++calls > 10100)
+			{
+				throw std::runtime_error("late failure");
+			}
+			return accumulator + value;
+		};
+		REQUIRE_THROWS_WITH(lagy::parallelInclusiveScan(container.begin(), container.end(), out.begin(), 0ll, add, 4), "late failure");
+	}
+}
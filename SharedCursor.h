@@ -0,0 +1,176 @@
+﻿#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <iterator>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace lagy {
+
+	/// <summary>
+	/// Hands out consecutive chunks of a random access range, for example of TransformIterators, to any number
+	/// of threads from a single atomic cursor.
+	///
+	/// Chunk sizes follow guided self-scheduling: each chunk is the remaining size divided by twice the worker
+	/// count, but never below the minimum chunk. Early chunks are large to keep the cursor cold, and the chunks
+	/// near the end shrink so workers finish close together even when elements vary in cost.
+	/// The cursor sits alone on its cache line so workers claiming chunks do not invalidate the range bounds.
+	/// </summary>
+	template <class Iterator>
+	class SharedCursor
+	{
+	public:
+		using difference_type = typename std::iterator_traits<Iterator>::difference_type;
+
+		/// <summary>
+		/// Constructor:
+		/// Creates a cursor at the start of [first, last).
+		/// </summary>
+		/// <param name="first"> The start of the range. </param>
+		/// <param name="last"> The end of the range. </param>
+		/// <param name="workerCount"> The number of workers expected to pull chunks. </param>
+		/// <param name="minChunk"> The smallest chunk handed out, except for the last one. </param>
+		SharedCursor(Iterator first, Iterator last, std::size_t workerCount, difference_type minChunk = 1) :
+			m_first(std::move(first)),
+			m_size(last - m_first),
+			m_divisor(2 * static_cast<difference_type>(std::max<std::size_t>(1, workerCount))),
+			m_minChunk(std::max<difference_type>(1, minChunk))
+		{
+		}
+
+		SharedCursor(const SharedCursor&) = delete;
+		SharedCursor& operator=(const SharedCursor&) = delete;
+
+		/// <summary>
+		/// Claims the next chunk. Safe to call from any thread.
+		/// </summary>
+		/// <return> The bounds of the chunk, or nothing if the range is exhausted. </return>
+		[[nodiscard]]
+		std::optional<std::pair<Iterator, Iterator>> next()
+		{
+			// the size is computed from a possibly stale position; fetch_add still hands out disjoint chunks
+			const difference_type seen = m_cursor.value.load(std::memory_order_relaxed);
+			if (seen >= m_size)
+			{
+				return std::nullopt;
+			}
+
+			const difference_type chunk = std::max(m_minChunk, (m_size - seen) / m_divisor);
+			const difference_type start = m_cursor.value.fetch_add(chunk, std::memory_order_relaxed);
+			if (start >= m_size)
+			{
+				return std::nullopt;
+			}
+			return std::make_pair(m_first + start, m_first + std::min(m_size, start + chunk));
+		}
+
+		/// <summary>
+		/// Gets the number of elements not yet claimed.
+		/// </summary>
+		[[nodiscard]]
+		difference_type remaining() const
+		{
+			return std::max<difference_type>(0, m_size - m_cursor.value.load(std::memory_order_relaxed));
+		}
+
+	private:
+
+		static constexpr std::size_t cacheLineSize = 64;
+
+		struct alignas(cacheLineSize) Cursor
+		{
+			std::atomic<difference_type> value{ 0 };
+		};
+
+		const Iterator m_first;
+		const difference_type m_size;
+		const difference_type m_divisor;
+		const difference_type m_minChunk;
+		Cursor m_cursor;
+	};
+
+	/// <summary>
+	/// Calls function(chunkFirst, chunkLast) on chunks of [first, last) pulled from a SharedCursor by several threads,
+	/// until the range is exhausted. The range must support random access.
+	/// If function throws, no further chunks are started, every thread is joined and the first exception is rethrown.
+	/// </summary>
+	/// <param name="first"> The start of the range. </param>
+	/// <param name="last"> The end of the range. </param>
+	/// <param name="function"> Called with the bounds of each chunk, concurrently from every thread. </param>
+	/// <param name="threadCount"> The number of threads. Zero uses the hardware concurrency. </param>
+	/// <param name="minChunk"> The smallest chunk handed out, except for the last one. </param>
+	template <class Iterator, class Function>
+	void parallelForChunks(Iterator first, Iterator last, Function function, std::size_t threadCount = 0,
+		typename std::iterator_traits<Iterator>::difference_type minChunk = 1)
+	{
+		if (threadCount == 0)
+		{
+			threadCount = std::max(1u, std::thread::hardware_concurrency());
+		}
+
+		SharedCursor<Iterator> cursor(std::move(first), std::move(last), threadCount, minChunk);
+		std::atomic<bool> failed{ false };
+		std::mutex errorMutex;
+		std::exception_ptr firstError;
+		auto fail = [&](std::exception_ptr error)
+		{
+			std::lock_guard lock(errorMutex);
+			if (!firstError)
+			{
+				firstError = std::move(error);
+			}
+			failed.store(true, std::memory_order_relaxed);
+		};
+
+		auto work = [&]()
+		{
+			try
+			{
+				while (!failed.load(std::memory_order_relaxed))
+				{
+					auto chunk = cursor.next();
+					if (!chunk)
+					{
+						break;
+					}
+					std::invoke(function, chunk->first, chunk->second);
+				}
+			}
+			catch (...)
+			{
+				fail(std::current_exception());
+			}
+		};
+
+		std::vector<std::thread> threads;
+		try
+		{
+			for (std::size_t i = 1; i < threadCount; ++i)
+			{
+				threads.emplace_back(work);
+			}
+		}
+		catch (...)
+		{
+			// the threads already started stop at their next chunk
+			fail(std::current_exception());
+		}
+		work();
+		for (std::thread& thread : threads)
+		{
+			thread.join();
+		}
+
+		if (firstError)
+		{
+			std::rethrow_exception(firstError);
+		}
+	}
+}
@@ -0,0 +1,89 @@
+﻿#include "catch2/catch.hpp"
+#include "SharedCursor.h"
+#include "TransformIterator.h"
+
+#include <atomic>
+#include <numeric>
+#include <stdexcept>
+#include <vector>
+
+TEST_CASE("SharedCursor hands out shrinking disjoint chunks", "[SharedCursor]")
+{
+	std::vector<int> values(1000);
+	lagy::SharedCursor<std::vector<int>::iterator> cursor(values.begin(), values.end(), 4, 8);
+	REQUIRE(cursor.remaining() == 1000);
+
+	std::vector<std::ptrdiff_t> sizes;
+	auto expectedStart = values.begin();
+	while (auto chunk = cursor.next())
+	{
+		REQUIRE(chunk->first == expectedStart);
+		sizes.push_back(chunk->second - chunk->first);
+		expectedStart = chunk->second;
+	}
+	REQUIRE(expectedStart == values.end());
+	REQUIRE(cursor.remaining() == 0);
+
+	REQUIRE(sizes.front() == 125);
+	REQUIRE(std::is_sorted(sizes.rbegin(), sizes.rend()));
+	REQUIRE(sizes[sizes.size() - 2] == 8);
+}
+
+TEST_CASE("parallelForChunks visits every element of a TransformIterator range once", "[SharedCursor]")
+{
+	std::vector<int> values(20000);
+	std::iota(values.begin(), values.end(), 0);
+	std::vector<std::atomic<int>> visits(values.size());
+
+	auto square = [](const std::vector<int>::const_iterator& it) { return static_cast<long long>(*it) * *it; };
+	lagy::TransformIterator begin(values.cbegin(), square);
+	lagy::TransformIterator end(values.cend(), square);
+
+	std::atomic<long long> total = 0;
+	lagy::parallelForChunks(begin, end, [&](auto chunkFirst, auto chunkLast)
+	{
+		for (; chunkFirst != chunkLast; ++chunkFirst)
+		{
+			++visits[static_cast<std::size_t>(chunkFirst.getWrappedIterator() - values.cbegin())];
+			total += *chunkFirst;
+		}
+	}, 4, 16);
+
+	long long expected = 0;
+	for (int value : values)
+	{
+		expected += static_cast<long long>(value) * value;
+	}
+	REQUIRE(total == expected);
+	REQUIRE(std::all_of(visits.begin(), visits.end(), [](const std::atomic<int>& count) { return count == 1; }));
+}
+
+TEST_CASE("parallelForChunks rethrows the first exception after joining every thread", "[SharedCursor]")
+{
+	std::vector<int> container(100000);
+	std::iota(container.begin(), container.end(), 0);
+
+	SECTION("One chunk fails")
+	{
+		std::atomic<int> visited{ 0 };
+		auto function = [&visited](std::vector<int>::iterator first, std::vector<int>::iterator last)
+		{
+			if (*first <= 50000 && 50000 <= *(last - 1))
+			{
+				throw std::runtime_error("chunk failed");
+			}
+			visited += static_cast<int>(last - first);
+		};
+		REQUIRE_THROWS_WITH(lagy::parallelForChunks(container.begin(), container.end(), function, 4, 64), "chunk failed");
+		REQUIRE(visited < static_cast<int>(container.size()));
+	}
+
+	SECTION("Every thread fails")
+	{
+		auto function = [](std::vector<int>::iterator, std::vector<int>::iterator)
+		{
+			throw std::runtime_error("every chunk failed");
+		};
+		REQUIRE_THROWS_WITH(lagy::parallelForChunks(container.begin(), container.end(), function, 8), "every chunk failed");
+	}
+}
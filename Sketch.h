@@ -0,0 +1,428 @@
+﻿#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <iterator>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace lagy {
+
+	namespace Detail
+	{
+		/// <summary>
+		/// Finalizer of SplitMix64. Spreads the entropy of every input bit over the whole result.
+		/// </summary>
+		[[nodiscard]]
+		inline std::uint64_t mixHash(std::uint64_t value)
+		{
+			value = (value ^ (value >> 30)) * 0xBF58476D1CE4E5B9ull;
+			value = (value ^ (value >> 27)) * 0x94D049BB133111EBull;
+			return value ^ (value >> 31);
+		}
+
+		/// <summary>
+		/// Hashes a key to 64 well mixed bits.
+		/// Integral keys are mixed directly, everything else goes through std::hash first.
+		/// </summary>
+		template <class Key>
+		[[nodiscard]]
+		std::uint64_t hashKey(const Key& key)
+		{
+			if constexpr (std::is_integral_v<Key> || std::is_enum_v<Key>)
+			{
+				return mixHash(static_cast<std::uint64_t>(key));
+			}
+			else
+			{
+				return mixHash(static_cast<std::uint64_t>(std::hash<Key>{}(key)));
+			}
+		}
+
+		/// <summary>
+		/// Hashes the keys of [first, last) in blocks and passes each block of hashes to consume.
+		/// Keys are gathered before hashing so the hash loop runs over a plain array, which the compiler
+		/// vectorizes for integral keys.
+		/// </summary>
+		template <class InputIterator, class BlockConsumer>
+		void forEachHashBlock(InputIterator first, InputIterator last, BlockConsumer&& consume)
+		{
+			using Key = std::decay_t<decltype(*first)>;
+			constexpr std::size_t blockSize = 64;
+
+			std::uint64_t hashes[blockSize];
+			if constexpr (std::is_integral_v<Key>)
+			{
+				Key keys[blockSize];
+				while (first != last)
+				{
+					std::size_t count = 0;
+					for (; count < blockSize && first != last; ++count, ++first)
+					{
+						keys[count] = *first;
+					}
+					for (std::size_t i = 0; i < count; ++i)
+					{
+						hashes[i] = mixHash(static_cast<std::uint64_t>(keys[i]));
+					}
+					consume(hashes, count);
+				}
+			}
+			else
+			{
+				while (first != last)
+				{
+					std::size_t count = 0;
+					for (; count < blockSize && first != last; ++count, ++first)
+					{
+						hashes[count] = hashKey(*first);
+					}
+					consume(hashes, count);
+				}
+			}
+		}
+
+		[[nodiscard]]
+		inline int countLeadingZeros(std::uint64_t value)
+		{
+#if defined(__GNUC__) || defined(__clang__)
+			return value == 0 ? 64 : __builtin_clzll(value);
+#else
+			int count = 0;
+			for (std::uint64_t bit = std::uint64_t{ 1 } << 63; bit != 0 && (value & bit) == 0; bit >>= 1)
+			{
+				++count;
+			}
+			return count;
+#endif
+		}
+	}
+
+	/// <summary>
+	/// A HyperLogLog estimator of the number of distinct keys inserted into it.
+	/// Uses 2^Precision one byte registers; the standard error of the estimate is about 1.04 / sqrt(2^Precision).
+	/// </summary>
+	template <unsigned Precision = 14>
+	class HyperLogLog
+	{
+	public:
+		static_assert(Precision >= 4 && Precision <= 18, "HyperLogLog precision must be between 4 and 18.");
+
+		/// <summary>
+		/// The number of registers.
+		/// </summary>
+		static constexpr std::size_t registerCount = std::size_t{ 1 } << Precision;
+
+		HyperLogLog() :
+			m_registers(registerCount, 0)
+		{
+		}
+
+		/// <summary>
+		/// Records an already hashed key.
+		/// </summary>
+		/// <param name="hash"> 64 well mixed bits identifying the key. </param>
+		void addHash(std::uint64_t hash)
+		{
+			const std::size_t index = static_cast<std::size_t>(hash >> (64 - Precision));
+			const std::uint64_t remaining = (hash << Precision) | (std::uint64_t{ 1 } << (Precision - 1));
+			const auto rank = static_cast<std::uint8_t>(Detail::countLeadingZeros(remaining) + 1);
+			m_registers[index] = std::max(m_registers[index], rank);
+		}
+
+		/// <summary>
+		/// Records a key.
+		/// </summary>
+		template <class Key>
+		void add(const Key& key)
+		{
+			addHash(Detail::hashKey(key));
+		}
+
+		/// <summary>
+		/// Records a key. Allows the sketch to be used wherever a consumer of values is expected.
+		/// </summary>
+		template <class Key>
+		void operator()(const Key& key)
+		{
+			add(key);
+		}
+
+		/// <summary>
+		/// Records every key of [first, last), hashing them in blocks.
+		/// </summary>
+		template <class InputIterator>
+		void insert(InputIterator first, InputIterator last)
+		{
+			Detail::forEachHashBlock(std::move(first), std::move(last), [this](const std::uint64_t* hashes, std::size_t count)
+			{
+				for (std::size_t i = 0; i < count; ++i)
+				{
+					addHash(hashes[i]);
+				}
+			});
+		}
+
+		/// <summary>
+		/// Combines the keys recorded by another sketch into this one.
+		/// </summary>
+		void merge(const HyperLogLog& other)
+		{
+			for (std::size_t i = 0; i < registerCount; ++i)
+			{
+				m_registers[i] = std::max(m_registers[i], other.m_registers[i]);
+			}
+		}
+
+		/// <summary>
+		/// Creates a sketch of the same shape with no keys recorded.
+		/// </summary>
+		[[nodiscard]]
+		HyperLogLog emptyCopy() const
+		{
+			return HyperLogLog();
+		}
+
+		/// <summary>
+		/// Estimates the number of distinct keys recorded.
+		/// </summary>
+		[[nodiscard]]
+		double estimate() const
+		{
+			constexpr double m = static_cast<double>(registerCount);
+			constexpr double alpha = 0.7213 / (1.0 + 1.079 / m);
+
+			double sum = 0.0;
+			std::size_t zeroRegisters = 0;
+			for (std::uint8_t value : m_registers)
+			{
+				sum += std::ldexp(1.0, -static_cast<int>(value));
+				zeroRegisters += (value == 0);
+			}
+
+			const double raw = alpha * m * m / sum;
+			if (raw <= 2.5 * m && zeroRegisters != 0)
+			{
+				// linear counting is more accurate for small cardinalities
+				return m * std::log(m / static_cast<double>(zeroRegisters));
+			}
+			return raw;
+		}
+
+	private:
+		std::vector<std::uint8_t> m_registers;
+	};
+
+	/// <summary>
+	/// A count-min sketch estimating how often each key was inserted.
+	/// Estimates never undercount; with width w and depth d they overcount by more than
+	/// e / w times the total count with probability at most e^-d.
+	/// </summary>
+	class CountMinSketch
+	{
+	public:
+
+		/// <summary>
+		/// Constructor:
+		/// Creates an empty sketch.
+		/// </summary>
+		/// <param name="width"> The number of counters per row. Must not be zero. </param>
+		/// <param name="depth"> The number of rows. Must not be zero. </param>
+		CountMinSketch(std::size_t width, std::size_t depth) :
+			m_width(width),
+			m_depth(depth)
+		{
+			if (width == 0 || depth == 0)
+			{
+				throw std::invalid_argument("CountMinSketch must have at least one row and one counter per row.");
+			}
+			m_counters.assign(width * depth, 0);
+		}
+
+		/// <summary>
+		/// Records count occurrences of an already hashed key.
+		/// </summary>
+		/// <param name="hash"> 64 well mixed bits identifying the key. </param>
+		/// <param name="count"> The number of occurrences. </param>
+		void addHash(std::uint64_t hash, std::uint64_t count = 1)
+		{
+			for (std::size_t row = 0; row < m_depth; ++row)
+			{
+				m_counters[row * m_width + column(hash, row)] += count;
+			}
+		}
+
+		/// <summary>
+		/// Records count occurrences of a key.
+		/// </summary>
+		template <class Key>
+		void add(const Key& key, std::uint64_t count = 1)
+		{
+			addHash(Detail::hashKey(key), count);
+		}
+
+		/// <summary>
+		/// Records an occurrence of a key. Allows the sketch to be used wherever a consumer of values is expected.
+		/// </summary>
+		template <class Key>
+		void operator()(const Key& key)
+		{
+			add(key);
+		}
+
+		/// <summary>
+		/// Records every key of [first, last), hashing them in blocks.
+		/// </summary>
+		template <class InputIterator>
+		void insert(InputIterator first, InputIterator last)
+		{
+			Detail::forEachHashBlock(std::move(first), std::move(last), [this](const std::uint64_t* hashes, std::size_t count)
+			{
+				for (std::size_t i = 0; i < count; ++i)
+				{
+					addHash(hashes[i]);
+				}
+			});
+		}
+
+		/// <summary>
+		/// Combines the counts recorded by another sketch of the same shape into this one.
+		/// </summary>
+		void merge(const CountMinSketch& other)
+		{
+			for (std::size_t i = 0; i < m_counters.size(); ++i)
+			{
+				m_counters[i] += other.m_counters[i];
+			}
+		}
+
+		/// <summary>
+		/// Creates a sketch of the same shape with no keys recorded.
+		/// </summary>
+		[[nodiscard]]
+		CountMinSketch emptyCopy() const
+		{
+			return CountMinSketch(m_width, m_depth);
+		}
+
+		/// <summary>
+		/// Estimates how often a key was recorded.
+		/// </summary>
+		template <class Key>
+		[[nodiscard]]
+		std::uint64_t estimate(const Key& key) const
+		{
+			const std::uint64_t hash = Detail::hashKey(key);
+			std::uint64_t result = UINT64_MAX;
+			for (std::size_t row = 0; row < m_depth; ++row)
+			{
+				result = std::min(result, m_counters[row * m_width + column(hash, row)]);
+			}
+			return result;
+		}
+
+	private:
+
+		[[nodiscard]]
+		std::size_t column(std::uint64_t hash, std::size_t row) const
+		{
+			// rows use independent hashes derived from the two halves of one hash
+			const std::uint64_t rowHash = (hash & 0xFFFFFFFFull) + row * ((hash >> 32) | 1);
+			return static_cast<std::size_t>(rowHash % m_width);
+		}
+
+		std::size_t m_width;
+		std::size_t m_depth;
+		std::vector<std::uint64_t> m_counters;
+	};
+
+	/// <summary>
+	/// Records every key of [first, last) into a sketch using several threads.
+	/// Each thread fills its own empty copy of the sketch over a contiguous part of the range,
+	/// and the copies are merged into the sketch afterwards.
+	///
+	/// The iterators must support random access arithmetic, as random access TransformIterators do.
+	/// If recording a key throws, every thread is joined, the sketch is left unchanged and the first exception is rethrown.
+	/// </summary>
+	/// <param name="sketch"> The sketch to record into. HyperLogLog, CountMinSketch or any type with insert, merge and emptyCopy. </param>
+	/// <param name="first"> The start of the keys. </param>
+	/// <param name="last"> The end of the keys. </param>
+	/// <param name="threadCount"> The number of threads. Zero uses the hardware concurrency. </param>
+	template <class Sketch, class Iterator>
+	void parallelInsert(Sketch& sketch, Iterator first, Iterator last, std::size_t threadCount = 0)
+	{
+		if (threadCount == 0)
+		{
+			threadCount = std::max(1u, std::thread::hardware_concurrency());
+		}
+
+		const auto size = static_cast<std::size_t>(last - first);
+		threadCount = std::max<std::size_t>(1, std::min(threadCount, size));
+
+		std::vector<Sketch> partials;
+		partials.reserve(threadCount);
+		for (std::size_t i = 0; i < threadCount; ++i)
+		{
+			partials.push_back(sketch.emptyCopy());
+		}
+
+		std::mutex errorMutex;
+		std::exception_ptr firstError;
+		auto fail = [&errorMutex, &firstError](std::exception_ptr error)
+		{
+			std::lock_guard lock(errorMutex);
+			if (!firstError)
+			{
+				firstError = std::move(error);
+			}
+		};
+
+		std::vector<std::thread> threads;
+		threads.reserve(threadCount);
+		try
+		{
+			for (std::size_t i = 0; i < threadCount; ++i)
+			{
+				const auto begin = static_cast<std::ptrdiff_t>(size * i / threadCount);
+				const auto end = static_cast<std::ptrdiff_t>(size * (i + 1) / threadCount);
+				threads.emplace_back([&partials, &fail, i, partBegin = first + begin, partEnd = first + end]()
+				{
+					try
+					{
+						partials[i].insert(partBegin, partEnd);
+					}
+					catch (...)
+					{
+						fail(std::current_exception());
+					}
+				});
+			}
+		}
+		catch (...)
+		{
+			fail(std::current_exception());
+		}
+
+		for (std::thread& thread : threads)
+		{
+			thread.join();
+		}
+		if (firstError)
+		{
+			std::rethrow_exception(firstError);
+		}
+
+		for (const Sketch& partial : partials)
+		{
+			sketch.merge(partial);
+		}
+	}
+}
\ No newline at end of file
@@ -0,0 +1,124 @@
+﻿#include "catch2/catch.hpp"
+#include "Sketch.h"
+#include "TransformIterator.h"
+
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace
+{
+	struct Record
+	{
+		std::uint64_t userId;
+		std::string country;
+	};
+
+	std::vector<Record> makeRecords(std::size_t count, std::uint64_t distinctUsers)
+	{
+		std::vector<Record> records;
+		records.reserve(count);
+		for (std::size_t i = 0; i < count; ++i)
+		{
+			records.push_back({ (i * 7919) % distinctUsers, (i % 10 == 0) ? "nz" : "us" });
+		}
+		return records;
+	}
+}
+
+TEST_CASE("HyperLogLog estimates distinct keys of a transformed range", "[Sketch]")
+{
+	const auto records = makeRecords(200000, 50000);
+	auto userId = [](const std::vector<Record>::const_iterator& it) { return it->userId; };
+	lagy::TransformIterator begin(records.cbegin(), userId);
+	lagy::TransformIterator end(records.cend(), userId);
+
+	SECTION("Sequential insertion")
+	{
+		lagy::HyperLogLog<> sketch;
+		sketch.insert(begin, end);
+		REQUIRE(sketch.estimate() == Approx(50000).epsilon(0.03));
+	}
+
+	SECTION("Parallel insertion gives the same estimate as sequential insertion")
+	{
+		lagy::HyperLogLog<> sequential;
+		sequential.insert(begin, end);
+
+		lagy::HyperLogLog<> parallel;
+		lagy::parallelInsert(parallel, begin, end, 4);
+		REQUIRE(parallel.estimate() == sequential.estimate());
+	}
+
+	SECTION("Small cardinalities are estimated closely")
+	{
+		lagy::HyperLogLog<> sketch;
+		for (int i = 0; i < 3; ++i)
+		{
+			sketch.add(std::string("a"));
+			sketch.add(std::string("b"));
+			sketch.add(std::string("c"));
+		}
+		REQUIRE(sketch.estimate() == Approx(3).epsilon(0.01));
+	}
+}
+
+TEST_CASE("CountMinSketch estimates key frequencies of a transformed range", "[Sketch]")
+{
+	const auto records = makeRecords(100000, 1000);
+	auto country = [](const std::vector<Record>::const_iterator& it) { return it->country; };
+	lagy::TransformIterator begin(records.cbegin(), country);
+	lagy::TransformIterator end(records.cend(), country);
+
+	SECTION("Sequential insertion")
+	{
+		lagy::CountMinSketch sketch(1024, 4);
+		sketch.insert(begin, end);
+		REQUIRE(sketch.estimate(std::string("nz")) >= 10000);
+		REQUIRE(sketch.estimate(std::string("nz")) <= 10000 + 100000 / 100);
+		REQUIRE(sketch.estimate(std::string("us")) >= 90000);
+		REQUIRE(sketch.estimate(std::string("fr")) <= 100000 / 100);
+	}
+
+	SECTION("Parallel insertion matches sequential insertion")
+	{
+		lagy::CountMinSketch sequential(1024, 4);
+		sequential.insert(begin, end);
+
+		lagy::CountMinSketch parallel(1024, 4);
+		lagy::parallelInsert(parallel, begin, end, 3);
+		for (const char* key : { "nz", "us", "fr" })
+		{
+			REQUIRE(parallel.estimate(std::string(key)) == sequential.estimate(std::string(key)));
+		}
+	}
+}
+
+TEST_CASE("Sketch errors are reported", "[Sketch]")
+{
+	SECTION("A count-min sketch needs at least one row and one column")
+	{
+		REQUIRE_THROWS_AS(lagy::CountMinSketch(0, 4), std::invalid_argument);
+		REQUIRE_THROWS_AS(lagy::CountMinSketch(1024, 0), std::invalid_argument);
+	}
+
+	SECTION("A failing key stops parallel insertion and leaves the sketch unchanged")
+	{
+		const auto records = makeRecords(10000, 100);
+		auto country = [](const std::vector<Record>::const_iterator& it)
+		{
+			if (it->userId == 42)
+			{
+				throw std::runtime_error("bad record");
+			}
+			return it->country;
+		};
+		lagy::TransformIterator begin(records.cbegin(), country);
+		lagy::TransformIterator end(records.cend(), country);
+
+		lagy::CountMinSketch sketch(1024, 4);
+		REQUIRE_THROWS_WITH(lagy::parallelInsert(sketch, begin, end, 4), "bad record");
+		REQUIRE(sketch.estimate(std::string("us")) == 0);
+	}
+}
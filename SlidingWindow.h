@@ -0,0 +1,329 @@
+﻿#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <type_traits>
+#include <utility>
+
+namespace lagy {
+
+	/// <summary>
+	/// Window aggregator keeping the sum of the values in the window.
+	/// </summary>
+	template <class T>
+	class WindowSum
+	{
+	public:
+		using value_type = T;
+		using result_type = T;
+
+		/// <summary>
+		/// Adds a value entering the window.
+		/// </summary>
+		void push(const T& value)
+		{
+			m_sum += value;
+		}
+
+		/// <summary>
+		/// Removes the oldest value of the window.
+		/// </summary>
+		void pop(const T& value)
+		{
+			m_sum -= value;
+		}
+
+		/// <summary>
+		/// Gets the aggregate of the values in the window.
+		/// </summary>
+		[[nodiscard]]
+		result_type result() const
+		{
+			return m_sum;
+		}
+
+	private:
+		T m_sum{};
+	};
+
+	/// <summary>
+	/// Window aggregator keeping the extreme value of the window with a monotonic deque.
+	/// Every value is added and removed from the deque at most once, so updates are amortized O(1).
+	/// Compare(a, b) is true if a should be preferred over b; std::less keeps the minimum.
+	/// </summary>
+	template <class T, std::size_t WindowSize, class Compare = std::less<T>>
+	class WindowExtreme
+	{
+	public:
+		using value_type = T;
+		using result_type = T;
+
+		/// <summary>
+		/// Adds a value entering the window.
+		/// </summary>
+		void push(const T& value)
+		{
+			while (m_count != 0 && !m_compare(back(), value))
+			{
+				--m_count;
+			}
+			m_candidates[(m_first + m_count) % WindowSize] = { value, m_pushed++ };
+			++m_count;
+		}
+
+		/// <summary>
+		/// Removes the oldest value of the window.
+		/// </summary>
+		void pop(const T&)
+		{
+			if (m_count != 0 && m_candidates[m_first].second == m_popped)
+			{
+				m_first = (m_first + 1) % WindowSize;
+				--m_count;
+			}
+			++m_popped;
+		}
+
+		/// <summary>
+		/// Gets the aggregate of the values in the window.
+		/// </summary>
+		[[nodiscard]]
+		result_type result() const
+		{
+			return m_candidates[m_first].first;
+		}
+
+	private:
+
+		[[nodiscard]]
+		const T& back() const
+		{
+			return m_candidates[(m_first + m_count - 1) % WindowSize].first;
+		}
+
+		std::array<std::pair<T, std::size_t>, WindowSize> m_candidates{};
+		std::size_t m_first = 0;
+		std::size_t m_count = 0;
+		std::size_t m_pushed = 0;
+		std::size_t m_popped = 0;
+		Compare m_compare{};
+	};
+
+	/// <summary>
+	/// Window aggregator keeping the minimum of the window.
+	/// </summary>
+	template <class T, std::size_t WindowSize>
+	using WindowMin = WindowExtreme<T, WindowSize, std::less<T>>;
+
+	/// <summary>
+	/// Window aggregator keeping the maximum of the window.
+	/// </summary>
+	template <class T, std::size_t WindowSize>
+	using WindowMax = WindowExtreme<T, WindowSize, std::greater<T>>;
+
+	/// <summary>
+	/// Window aggregator keeping a polynomial rolling hash (Rabin-Karp) of the window modulo 2^64,
+	/// suitable for n-gram hashing. Equal windows always have equal hashes.
+	/// </summary>
+	template <class T, std::size_t WindowSize>
+	class WindowRollingHash
+	{
+	public:
+		using value_type = T;
+		using result_type = std::uint64_t;
+
+		/// <summary>
+		/// Adds a value entering the window.
+		/// </summary>
+		void push(const T& value)
+		{
+			m_hash = m_hash * base + static_cast<std::uint64_t>(value);
+		}
+
+		/// <summary>
+		/// Removes the oldest value of the window.
+		/// </summary>
+		void pop(const T& value)
+		{
+			m_hash -= static_cast<std::uint64_t>(value) * outgoingFactor();
+		}
+
+		/// <summary>
+		/// Gets the aggregate of the values in the window.
+		/// </summary>
+		[[nodiscard]]
+		result_type result() const
+		{
+			return m_hash;
+		}
+
+	private:
+		static constexpr std::uint64_t base = 0x100000001B3ull;
+
+		[[nodiscard]]
+		static constexpr std::uint64_t outgoingFactor()
+		{
+			// the oldest value is popped before the newest is pushed, so it was multiplied WindowSize - 1 times
+			std::uint64_t factor = 1;
+			for (std::size_t i = 1; i < WindowSize; ++i)
+			{
+				factor *= base;
+			}
+			return factor;
+		}
+
+		std::uint64_t m_hash = 0;
+	};
+
+	/// <summary>
+	/// An input iterator yielding an aggregate over every window of WindowSize consecutive elements of a range.
+	///
+	/// Each element of the wrapped range, for example a TransformIterator, is dereferenced exactly once and kept
+	/// in a ring buffer until it leaves the window; the aggregator is updated in O(1) per step instead of
+	/// recomputing the whole window. A range of N elements yields N - WindowSize + 1 windows.
+	/// </summary>
+	template <class Iterator, std::size_t WindowSize, class Aggregator>
+	class SlidingWindowIterator
+	{
+	public:
+		static_assert(WindowSize > 0, "SlidingWindowIterator must be provided a non-empty window.");
+
+		using WrappedIteratorType = Iterator;
+		using element_type = typename Aggregator::value_type;
+
+		// std::iterator_traits types
+		using value_type = typename Aggregator::result_type;
+		using difference_type = typename std::iterator_traits<Iterator>::difference_type;
+		using pointer = const value_type*;
+		using reference = value_type;
+		using iterator_category = std::input_iterator_tag;
+
+		/// <summary>
+		/// Constructor:
+		/// Creates an iterator at the first full window of [first, last), or the end iterator if the range is shorter than a window.
+		/// </summary>
+		/// <param name="first"> The start of the range. </param>
+		/// <param name="last"> The end of the range. </param>
+		/// <param name="aggregator"> The aggregator, with an empty window. </param>
+		SlidingWindowIterator(Iterator first, Iterator last, Aggregator aggregator = Aggregator()) :
+			m_next(std::move(first)),
+			m_last(std::move(last)),
+			m_aggregator(std::move(aggregator))
+		{
+			for (; m_filled < WindowSize && m_next != m_last; ++m_filled, ++m_next)
+			{
+				m_window[m_filled] = *m_next;
+				m_aggregator.push(m_window[m_filled]);
+			}
+			m_atEnd = m_filled < WindowSize;
+		}
+
+		/// <summary>
+		/// Constructor:
+		/// Creates the end iterator.
+		/// </summary>
+		explicit SlidingWindowIterator(Iterator last) :
+			m_next(last),
+			m_last(std::move(last)),
+			m_atEnd(true)
+		{
+		}
+
+		/// <summary>
+		/// Gets the aggregate of the current window.
+		/// </summary>
+		[[nodiscard]]
+		reference operator*() const
+		{
+			return m_aggregator.result();
+		}
+
+		/// <summary>
+		/// Gets the element of the current window at an offset from its oldest element.
+		/// </summary>
+		[[nodiscard]]
+		const element_type& window(std::size_t offset) const
+		{
+			return m_window[(m_oldest + offset) % WindowSize];
+		}
+
+		/// <summary>
+		/// Slides the window forward by one element.
+		/// </summary>
+		SlidingWindowIterator& operator++()
+		{
+			if (m_next == m_last)
+			{
+				m_atEnd = true;
+				return *this;
+			}
+
+			element_type& slot = m_window[m_oldest];
+			m_aggregator.pop(slot);
+			slot = *m_next;
+			m_aggregator.push(slot);
+			m_oldest = (m_oldest + 1) % WindowSize;
+			++m_next;
+			return *this;
+		}
+
+		/// <summary>
+		/// Slides the window forward by one element.
+		/// Returns an iterator at the original window.
+		/// </summary>
+		[[nodiscard]]
+		SlidingWindowIterator operator++(int)
+		{
+			SlidingWindowIterator out(*this);
+			++(*this);
+			return out;
+		}
+
+		/// <summary>
+		/// Compare iterators for equality. Iterators are equal when both are at the end,
+		/// or when neither is and they will read the same next element.
+		/// </summary>
+		[[nodiscard]]
+		friend bool operator==(const SlidingWindowIterator& lhs, const SlidingWindowIterator& rhs)
+		{
+			return lhs.m_atEnd == rhs.m_atEnd && (lhs.m_atEnd || lhs.m_next == rhs.m_next);
+		}
+
+		/// <summary>
+		/// Compare iterators for inequality.
+		/// </summary>
+		[[nodiscard]]
+		friend bool operator!=(const SlidingWindowIterator& lhs, const SlidingWindowIterator& rhs)
+		{
+			return !(lhs == rhs);
+		}
+
+	private:
+		Iterator m_next;
+		Iterator m_last;
+		Aggregator m_aggregator;
+		std::array<element_type, WindowSize> m_window{};
+		std::size_t m_oldest = 0;
+		std::size_t m_filled = 0;
+		bool m_atEnd = false;
+	};
+
+	/// <summary>
+	/// Creates the begin and end iterators over the windows of [first, last).
+	/// </summary>
+	/// <param name="first"> The start of the range. </param>
+	/// <param name="last"> The end of the range. </param>
+	/// <param name="aggregator"> The aggregator, with an empty window. </param>
+	/// <return> The first window iterator and the end iterator. </return>
+	template <std::size_t WindowSize, class Aggregator, class Iterator>
+	[[nodiscard]]
+	std::pair<SlidingWindowIterator<Iterator, WindowSize, Aggregator>, SlidingWindowIterator<Iterator, WindowSize, Aggregator>> slidingWindows(
+		Iterator first, Iterator last, Aggregator aggregator = Aggregator())
+	{
+		using WindowIterator = SlidingWindowIterator<Iterator, WindowSize, Aggregator>;
+		return { WindowIterator(first, last, std::move(aggregator)), WindowIterator(last) };
+	}
+}
\ No newline at end of file
@@ -0,0 +1,83 @@
+﻿#include "catch2/catch.hpp"
+#include "SlidingWindow.h"
+#include "TransformIterator.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <numeric>
+#include <string>
+#include <vector>
+
+TEST_CASE("SlidingWindowIterator aggregates windows of a transformed range", "[SlidingWindow]")
+{
+	std::vector<int> container = { 5, 1, 4, 2, 8, 3, 7, 6, 0, 9 };
+	int evaluations = 0;
+	auto negate = [&evaluations](const std::vector<int>::iterator& it)
+	{
+		++evaluations;
+		return -*it;
+	};
+	lagy::TransformIterator begin(container.begin(), negate);
+	lagy::TransformIterator end(container.end(), negate);
+
+	// reference results computed by recomputing every window
+	auto naive = [&container](std::size_t windowSize, auto aggregate)
+	{
+		std::vector<int> results;
+		for (std::size_t i = 0; i + windowSize <= container.size(); ++i)
+		{
+			std::vector<int> window;
+			for (std::size_t j = i; j < i + windowSize; ++j)
+			{
+				window.push_back(-container[j]);
+			}
+			results.push_back(aggregate(window));
+		}
+		return results;
+	};
+
+	SECTION("Moving sum evaluates each transform once")
+	{
+		auto [first, last] = lagy::slidingWindows<3, lagy::WindowSum<int>>(begin, end);
+		std::vector<int> sums(first, last);
+
+		REQUIRE(sums == naive(3, [](const std::vector<int>& window) { return std::accumulate(window.begin(), window.end(), 0); }));
+		REQUIRE(evaluations == static_cast<int>(container.size()));
+	}
+
+	SECTION("Rolling minimum and maximum")
+	{
+		auto [minFirst, minLast] = lagy::slidingWindows<4, lagy::WindowMin<int, 4>>(begin, end);
+		REQUIRE(std::vector<int>(minFirst, minLast) == naive(4, [](const std::vector<int>& window) { return *std::min_element(window.begin(), window.end()); }));
+
+		auto [maxFirst, maxLast] = lagy::slidingWindows<4, lagy::WindowMax<int, 4>>(begin, end);
+		REQUIRE(std::vector<int>(maxFirst, maxLast) == naive(4, [](const std::vector<int>& window) { return *std::max_element(window.begin(), window.end()); }));
+	}
+
+	SECTION("Ranges shorter than a window yield no windows")
+	{
+		auto [first, last] = lagy::slidingWindows<11, lagy::WindowSum<int>>(begin, end);
+		REQUIRE(first == last);
+	}
+
+	SECTION("The current window can be inspected")
+	{
+		lagy::SlidingWindowIterator<decltype(begin), 3, lagy::WindowSum<int>> window(begin, end);
+		++window;
+		REQUIRE(window.window(0) == -1);
+		REQUIRE(window.window(2) == -2);
+	}
+}
+
+TEST_CASE("WindowRollingHash hashes n-grams", "[SlidingWindow]")
+{
+	const std::string text = "abcabcxabc";
+	auto [first, last] = lagy::slidingWindows<3, lagy::WindowRollingHash<char, 3>>(text.begin(), text.end());
+	std::vector<std::uint64_t> hashes(first, last);
+
+	REQUIRE(hashes.size() == text.size() - 2);
+	REQUIRE(hashes[0] == hashes[3]);
+	REQUIRE(hashes[0] == hashes[7]);
+	REQUIRE(hashes[0] != hashes[1]);
+	REQUIRE(hashes[4] != hashes[0]);
+}
@@ -0,0 +1,418 @@
+﻿#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <exception>
+#include <iterator>
+#include <memory>
+#include <thread>
+#include <type_traits>
+#include <utility>
+
+namespace lagy {
+
+	/// <summary>
+	/// A bounded lock-free queue between exactly one producer thread and one consumer thread.
+	///
+	/// Each side keeps its position in a private index and publishes it to the other side only every
+	/// publishBatch elements, or when it would otherwise have to wait, so the shared indices (each on its
+	/// own cache line) are written once per batch instead of once per element.
+	///
+	/// T must be default constructible and move assignable.
+	/// </summary>
+	template <class T>
+	class SpscRing
+	{
+	public:
+
+		/// <summary>
+		/// Constructor:
+		/// Creates an empty ring.
+		/// </summary>
+		/// <param name="capacity"> The minimum number of elements the ring can hold. Rounded up to a power of two. </param>
+		/// <param name="publishBatch"> The number of elements each side processes before publishing its position. </param>
+		explicit SpscRing(std::size_t capacity, std::size_t publishBatch = 32) :
+			m_capacity(roundUpToPowerOfTwo(capacity)),
+			m_mask(m_capacity - 1),
+			m_publishBatch(std::max<std::size_t>(1, std::min(publishBatch, m_capacity / 2))),
+			m_slots(std::make_unique<T[]>(m_capacity))
+		{
+		}
+
+		SpscRing(const SpscRing&) = delete;
+		SpscRing& operator=(const SpscRing&) = delete;
+
+		/// <summary>
+		/// Gets the number of elements the ring can hold.
+		/// </summary>
+		[[nodiscard]]
+		std::size_t capacity() const
+		{
+			return m_capacity;
+		}
+
+		/// <summary>
+		/// Adds an element if there is space for it. Producer only.
+		/// </summary>
+		/// <return> True if the element was added. </return>
+		bool tryPush(T& value)
+		{
+			if (m_producer.index - m_producer.cachedOther == m_capacity)
+			{
+				m_producer.cachedOther = m_head.value.load(std::memory_order_acquire);
+				if (m_producer.index - m_producer.cachedOther == m_capacity)
+				{
+					publishTail();
+					return false;
+				}
+			}
+
+			m_slots[m_producer.index & m_mask] = std::move(value);
+			++m_producer.index;
+			if (m_producer.index - m_producer.published >= m_publishBatch)
+			{
+				publishTail();
+			}
+			return true;
+		}
+
+		/// <summary>
+		/// Adds an element, waiting for space if the ring is full. Producer only.
+		/// </summary>
+		/// <return> True if the element was added, false if the consumer abandoned the ring. </return>
+		bool push(T value)
+		{
+			while (!tryPush(value))
+			{
+				if (m_abandoned.load(std::memory_order_relaxed))
+				{
+					return false;
+				}
+				std::this_thread::yield();
+			}
+			return true;
+		}
+
+		/// <summary>
+		/// Makes every element added so far visible to the consumer. Producer only.
+		/// </summary>
+		void flush()
+		{
+			publishTail();
+		}
+
+		/// <summary>
+		/// Publishes the remaining elements and signals that no more will be added. Producer only.
+		/// </summary>
+		/// <param name="error"> The failure that stopped the producer, rethrown by pop once the remaining elements are removed. </param>
+		void close(std::exception_ptr error = nullptr)
+		{
+			publishTail();
+			m_error = std::move(error);
+			m_closed.store(true, std::memory_order_release);
+		}
+
+		/// <summary>
+		/// Removes the next element if one is available. Consumer only.
+		/// </summary>
+		/// <return> True if an element was removed into out. </return>
+		bool tryPop(T& out)
+		{
+			if (m_consumer.index == m_consumer.cachedOther)
+			{
+				m_consumer.cachedOther = m_tail.value.load(std::memory_order_acquire);
+				if (m_consumer.index == m_consumer.cachedOther)
+				{
+					publishHead();
+					return false;
+				}
+			}
+
+			out = std::move(m_slots[m_consumer.index & m_mask]);
+			++m_consumer.index;
+			if (m_consumer.index - m_consumer.published >= m_publishBatch)
+			{
+				publishHead();
+			}
+			return true;
+		}
+
+		/// <summary>
+		/// Removes the next element, waiting for one if the ring is empty. Consumer only.
+		/// </summary>
+		/// If the producer closed the ring with an error, the error is rethrown instead of returning false.
+		/// <return> True if an element was removed into out, false if the ring is closed and empty. </return>
+		bool pop(T& out)
+		{
+			while (!tryPop(out))
+			{
+				if (m_closed.load(std::memory_order_acquire))
+				{
+					// elements published before closing, and the error, are visible once the closed flag is
+					if (tryPop(out))
+					{
+						return true;
+					}
+					if (m_error)
+					{
+						std::rethrow_exception(m_error);
+					}
+					return false;
+				}
+				std::this_thread::yield();
+			}
+			return true;
+		}
+
+		/// <summary>
+		/// Signals that the consumer will not remove any more elements, releasing a waiting producer. Consumer only.
+		/// </summary>
+		void abandon()
+		{
+			m_abandoned.store(true, std::memory_order_relaxed);
+		}
+
+	private:
+
+		static constexpr std::size_t cacheLineSize = 64;
+
+		struct alignas(cacheLineSize) SharedIndex
+		{
+			std::atomic<std::size_t> value{ 0 };
+		};
+
+		struct alignas(cacheLineSize) LocalIndices
+		{
+			std::size_t index = 0;
+			std::size_t published = 0;
+			std::size_t cachedOther = 0;
+		};
+
+		[[nodiscard]]
+		static std::size_t roundUpToPowerOfTwo(std::size_t value)
+		{
+			std::size_t result = 2;
+			while (result < value)
+			{
+				result *= 2;
+			}
+			return result;
+		}
+
+		void publishTail()
+		{
+			m_producer.published = m_producer.index;
+			m_tail.value.store(m_producer.index, std::memory_order_release);
+		}
+
+		void publishHead()
+		{
+			m_consumer.published = m_consumer.index;
+			m_head.value.store(m_consumer.index, std::memory_order_release);
+		}
+
+		const std::size_t m_capacity;
+		const std::size_t m_mask;
+		const std::size_t m_publishBatch;
+		std::unique_ptr<T[]> m_slots;
+
+		SharedIndex m_head;
+		SharedIndex m_tail;
+		LocalIndices m_producer;
+		LocalIndices m_consumer;
+		alignas(cacheLineSize) std::atomic<bool> m_closed{ false };
+		std::atomic<bool> m_abandoned{ false };
+		std::exception_ptr m_error;
+	};
+
+	/// <summary>
+	/// An input iterator that removes elements from an SpscRing on the consumer thread.
+	/// A default constructed SpscRingIterator is the end of the sequence, reached once the ring is closed and empty.
+	/// </summary>
+	template <class T>
+	class SpscRingIterator
+	{
+	public:
+
+		// std::iterator_traits types
+		using value_type = T;
+		using difference_type = std::ptrdiff_t;
+		using pointer = const T*;
+		using reference = const T&;
+		using iterator_category = std::input_iterator_tag;
+
+		/// <summary>
+		/// Constructor:
+		/// Creates the end iterator.
+		/// </summary>
+		SpscRingIterator() = default;
+
+		/// <summary>
+		/// Constructor:
+		/// Creates an iterator at the next element of the ring, waiting for it if necessary.
+		/// </summary>
+		/// <param name="ring"> The ring to consume. </param>
+		explicit SpscRingIterator(SpscRing<T>& ring) :
+			m_ring(&ring)
+		{
+			++(*this);
+		}
+
+		/// <summary>
+		/// Gets the current element.
+		/// </summary>
+		[[nodiscard]]
+		reference operator*() const
+		{
+			return m_current;
+		}
+
+		/// <summary>
+		/// Gets the current element.
+		/// </summary>
+		[[nodiscard]]
+		pointer operator->() const
+		{
+			return &m_current;
+		}
+
+		/// <summary>
+		/// Moves to the next element of the ring, waiting for it if necessary.
+		/// </summary>
+		SpscRingIterator& operator++()
+		{
+			if (!m_ring->pop(m_current))
+			{
+				m_ring = nullptr;
+			}
+			return *this;
+		}
+
+		/// <summary>
+		/// Moves to the next element of the ring.
+		/// Returns an iterator holding a copy of the original element.
+		/// </summary>
+		[[nodiscard]]
+		SpscRingIterator operator++(int)
+		{
+			SpscRingIterator out(*this);
+			++(*this);
+			return out;
+		}
+
+		/// <summary>
+		/// Compare iterators for equality. Only the end of the sequence compares equal to the end iterator.
+		/// </summary>
+		[[nodiscard]]
+		friend bool operator==(const SpscRingIterator& lhs, const SpscRingIterator& rhs)
+		{
+			return lhs.m_ring == rhs.m_ring;
+		}
+
+		/// <summary>
+		/// Compare iterators for inequality.
+		/// </summary>
+		[[nodiscard]]
+		friend bool operator!=(const SpscRingIterator& lhs, const SpscRingIterator& rhs)
+		{
+			return !(lhs == rhs);
+		}
+
+	private:
+		SpscRing<T>* m_ring = nullptr;
+		T m_current{};
+	};
+
+	/// <summary>
+	/// Evaluates a range, typically of TransformIterators, on its own producer thread and exposes the
+	/// results to the owning thread as an ordinary input range.
+	/// Splitting a pipeline across two threads only requires wrapping its source.
+	///
+	/// If evaluating the range throws, the producer stops and the exception is rethrown on the consumer thread
+	/// when it moves past the last element produced. The destructor releases and joins the producer even if the
+	/// range was not fully consumed.
+	/// </summary>
+	template <class T>
+	class ThreadedSource
+	{
+	public:
+
+		/// <summary>
+		/// Constructor:
+		/// Starts a producer thread pushing the elements of [first, last) into a ring.
+		/// </summary>
+		/// <param name="first"> The start of the range to evaluate. </param>
+		/// <param name="last"> The end of the range to evaluate. </param>
+		/// <param name="capacity"> The capacity of the ring between the threads. </param>
+		template <class InputIterator>
+		ThreadedSource(InputIterator first, InputIterator last, std::size_t capacity = 1024) :
+			m_ring(std::make_unique<SpscRing<T>>(capacity))
+		{
+			m_producer = std::thread([ring = m_ring.get(), first = std::move(first), last = std::move(last)]() mutable
+			{
+				try
+				{
+					for (; first != last; ++first)
+					{
+						if (!ring->push(*first))
+						{
+							break;
+						}
+					}
+				}
+				catch (...)
+				{
+					ring->close(std::current_exception());
+					return;
+				}
+				ring->close();
+			});
+		}
+
+		ThreadedSource(ThreadedSource&&) = default;
+		ThreadedSource& operator=(ThreadedSource&&) = delete;
+
+		~ThreadedSource()
+		{
+			if (m_producer.joinable())
+			{
+				m_ring->abandon();
+				m_producer.join();
+			}
+		}
+
+		/// <summary>
+		/// Gets an iterator at the next unconsumed element. Call at most once.
+		/// </summary>
+		[[nodiscard]]
+		SpscRingIterator<T> begin()
+		{
+			return SpscRingIterator<T>(*m_ring);
+		}
+
+		/// <summary>
+		/// Gets the end iterator.
+		/// </summary>
+		[[nodiscard]]
+		SpscRingIterator<T> end() const
+		{
+			return SpscRingIterator<T>();
+		}
+
+	private:
+		std::unique_ptr<SpscRing<T>> m_ring;
+		std::thread m_producer;
+	};
+
+	/// <summary>
+	/// Creates a ThreadedSource over [first, last), deducing the element type from the range.
+	/// </summary>
+	template <class InputIterator>
+	[[nodiscard]]
+	ThreadedSource<std::decay_t<decltype(*std::declval<InputIterator&>())>> makeThreadedSource(
+		InputIterator first, InputIterator last, std::size_t capacity = 1024)
+	{
+		return ThreadedSource<std::decay_t<decltype(*std::declval<InputIterator&>())>>(std::move(first), std::move(last), capacity);
+	}
+}
\ No newline at end of file
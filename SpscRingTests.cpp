@@ -0,0 +1,127 @@
+﻿#include "catch2/catch.hpp"
+#include "SpscRing.h"
+#include "TransformIterator.h"
+
+#include <numeric>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+TEST_CASE("SpscRing passes elements between two threads in order", "[SpscRing]")
+{
+	SECTION("Single threaded push and pop respect capacity")
+	{
+		lagy::SpscRing<int> ring(4, 2);
+		REQUIRE(ring.capacity() == 4);
+
+		for (int i = 0; i < 4; ++i)
+		{
+			int value = i;
+			REQUIRE(ring.tryPush(value));
+		}
+		int overflow = 4;
+		REQUIRE(!ring.tryPush(overflow));
+
+		int out = -1;
+		for (int i = 0; i < 4; ++i)
+		{
+			REQUIRE(ring.tryPop(out));
+			REQUIRE(out == i);
+		}
+		REQUIRE(!ring.tryPop(out));
+	}
+
+	SECTION("A producer thread and a consumer thread exchange every element")
+	{
+		constexpr int count = 100000;
+		lagy::SpscRing<int> ring(64);
+
+		std::thread producer([&ring]()
+		{
+			for (int i = 0; i < count; ++i)
+			{
+				ring.push(i);
+			}
+			ring.close();
+		});
+
+		long long sum = 0;
+		int expected = 0;
+		bool ordered = true;
+		for (lagy::SpscRingIterator<int> it(ring), end; it != end; ++it)
+		{
+			ordered = ordered && *it == expected++;
+			sum += *it;
+		}
+		producer.join();
+
+		REQUIRE(ordered);
+		REQUIRE(expected == count);
+		REQUIRE(sum == static_cast<long long>(count) * (count - 1) / 2);
+	}
+}
+
+TEST_CASE("ThreadedSource evaluates a TransformIterator range on another thread", "[SpscRing]")
+{
+	std::vector<int> container(10000);
+	std::iota(container.begin(), container.end(), 0);
+
+	const auto consumerThread = std::this_thread::get_id();
+	auto toString = [consumerThread](const std::vector<int>::iterator& it)
+	{
+		return std::this_thread::get_id() != consumerThread ? std::to_string(*it) : std::string("same thread");
+	};
+	lagy::TransformIterator begin(container.begin(), toString);
+	lagy::TransformIterator end(container.end(), toString);
+
+	SECTION("Every transformed element arrives in order")
+	{
+		auto source = lagy::makeThreadedSource(begin, end, 128);
+		std::vector<std::string> results(source.begin(), source.end());
+
+		REQUIRE(results.size() == container.size());
+		REQUIRE(results.front() == "0");
+		REQUIRE(results.back() == "9999");
+	}
+
+	SECTION("Abandoning the source early releases the producer")
+	{
+		auto source = lagy::makeThreadedSource(begin, end, 16);
+		auto it = source.begin();
+		REQUIRE(*it == "0");
+		REQUIRE(*++it == "1");
+	}
+}
+
+TEST_CASE("ThreadedSource rethrows a failing transform on the consumer thread", "[SpscRing]")
+{
+	std::vector<int> container(1000);
+	std::iota(container.begin(), container.end(), 0);
+
+	auto failAt500 = [](const std::vector<int>::iterator& it)
+	{
+		if (*it == 500)
+		{
+			throw std::runtime_error("bad element");
+		}
+		return *it;
+	};
+	lagy::TransformIterator begin(container.begin(), failAt500);
+	lagy::TransformIterator end(container.end(), failAt500);
+
+	auto source = lagy::makeThreadedSource(begin, end, 64);
+	std::vector<int> results;
+	auto it = source.begin();
+	REQUIRE_THROWS_WITH([&]()
+	{
+		for (; it != source.end(); ++it)
+		{
+			results.push_back(*it);
+		}
+	}(), "bad element");
+
+	// every element produced before the failure was delivered
+	REQUIRE(results.size() == 500);
+	REQUIRE(results.back() == 499);
+}
@@ -0,0 +1,213 @@
+﻿#pragma once
+
+#include <array>
+#include <climits>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <type_traits>
+#include <utility>
+
+#include "CpuDispatch.h"
+
+namespace lagy {
+
+	namespace Detail
+	{
+		inline void lookupNibblesScalar(const std::uint8_t* table, const std::uint8_t* first, const std::uint8_t* last, std::uint8_t* out)
+		{
+			for (; first != last; ++first, ++out)
+			{
+				*out = table[*first & 0x0F];
+			}
+		}
+
+#if LAGY_X86_DISPATCH
+		__attribute__((target("ssse3")))
+		inline void lookupNibblesSse41(const std::uint8_t* table, const std::uint8_t* first, const std::uint8_t* last, std::uint8_t* out)
+		{
+			const __m128i entries = _mm_loadu_si128(reinterpret_cast<const __m128i*>(table));
+			const __m128i mask = _mm_set1_epi8(0x0F);
+			for (; last - first >= 16; first += 16, out += 16)
+			{
+				const __m128i indices = _mm_and_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(first)), mask);
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(out), _mm_shuffle_epi8(entries, indices));
+			}
+			lookupNibblesScalar(table, first, last, out);
+		}
+
+		__attribute__((target("avx2")))
+		inline void lookupNibblesAvx2(const std::uint8_t* table, const std::uint8_t* first, const std::uint8_t* last, std::uint8_t* out)
+		{
+			// vpshufb looks up within each 128 bit lane, so both lanes hold the whole table
+			const __m256i entries = _mm256_broadcastsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i*>(table)));
+			const __m256i mask = _mm256_set1_epi8(0x0F);
+			for (; last - first >= 32; first += 32, out += 32)
+			{
+				const __m256i indices = _mm256_and_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(first)), mask);
+				_mm256_storeu_si256(reinterpret_cast<__m256i*>(out), _mm256_shuffle_epi8(entries, indices));
+			}
+			lookupNibblesScalar(table, first, last, out);
+		}
+
+		__attribute__((target("avx512f,avx512bw")))
+		inline void lookupNibblesAvx512(const std::uint8_t* table, const std::uint8_t* first, const std::uint8_t* last, std::uint8_t* out)
+		{
+			const __m512i entries = _mm512_broadcast_i32x4(_mm_loadu_si128(reinterpret_cast<const __m128i*>(table)));
+			const __m512i mask = _mm512_set1_epi8(0x0F);
+			for (; last - first >= 64; first += 64, out += 64)
+			{
+				const __m512i indices = _mm512_and_si512(_mm512_loadu_si512(first), mask);
+				_mm512_storeu_si512(out, _mm512_shuffle_epi8(entries, indices));
+			}
+			lookupNibblesScalar(table, first, last, out);
+		}
+#endif
+	}
+
+	/// <summary>
+	/// A UnaryOperation for TransformIterator that replaces a function over a small integral domain
+	/// with a load from a table filled once, when the table is constructed. Construction is constexpr,
+	/// so a table over a constexpr function can be built at compile time.
+	///
+	/// Inputs are reduced to their low DomainBits bits before the lookup. Copying a LookupTable copies the
+	/// whole table; pass large tables to TransformIterator through std::cref.
+	/// </summary>
+	template <class Domain, class Result, std::size_t DomainBits = sizeof(Domain) * CHAR_BIT>
+	class LookupTable
+	{
+	public:
+		static_assert(std::is_integral_v<Domain>, "LookupTable must be provided an integral domain.");
+		static_assert(DomainBits > 0 && DomainBits <= 16, "LookupTable only supports domains of at most 16 bits.");
+		static_assert(DomainBits <= sizeof(Domain) * CHAR_BIT, "LookupTable can not index more bits than the domain type holds.");
+
+		using domain_type = Domain;
+		using result_type = Result;
+
+		/// <summary>
+		/// The block kernel of 16 entry tables of single byte results: looks up the low four bits of every byte of
+		/// [first, last) in the 16 bytes at table, writing the results to out.
+		/// </summary>
+		using Kernel = void(const std::uint8_t* table, const std::uint8_t* first, const std::uint8_t* last, std::uint8_t* out);
+
+		/// <summary>
+		/// The number of entries in the table.
+		/// </summary>
+		static constexpr std::size_t size = std::size_t{ 1 } << DomainBits;
+
+		/// <summary>
+		/// Constructor:
+		/// Evaluates the function once for every value of the domain and stores the results.
+		/// </summary>
+		/// <param name="function"> function mapping a domain value to its result. </param>
+		template <class Function>
+		constexpr explicit LookupTable(Function function) :
+			m_table{}
+		{
+			for (std::size_t i = 0; i < size; ++i)
+			{
+				m_table[i] = function(static_cast<Domain>(i));
+			}
+		}
+
+		/// <summary>
+		/// Looks up the result for a domain value.
+		/// </summary>
+		/// <param name="value"> The domain value. Only its low DomainBits bits are used. </param>
+		/// <return> The tabulated result for the value. </return>
+		[[nodiscard]]
+		constexpr const Result& operator[](Domain value) const
+		{
+			return m_table[static_cast<std::make_unsigned_t<Domain>>(value) & (size - 1)];
+		}
+
+		/// <summary>
+		/// Looks up the result for the value an iterator refers to.
+		/// Allows a LookupTable to be used directly as the UnaryOperation of a TransformIterator.
+		/// </summary>
+		/// <param name="it"> The iterator to dereference. </param>
+		/// <return> The tabulated result for the dereferenced value. </return>
+		template <class Iterator>
+		[[nodiscard]]
+		constexpr const Result& operator()(const Iterator& it) const
+		{
+			return (*this)[static_cast<Domain>(*it)];
+		}
+
+		/// <summary>
+		/// Gets the block kernel compiled for the highest level not above isa.
+		/// Only 16 entry tables of single byte results have a block kernel.
+		/// </summary>
+		[[nodiscard]]
+		static Kernel* kernelFor(Isa isa)
+		{
+			static_assert(size == 16 && sizeof(Result) == 1, "Only 16 entry tables of single byte results have a block kernel.");
+			static constexpr KernelVariant<Kernel> variants[] = {
+				{ Isa::Scalar, &Detail::lookupNibblesScalar },
+#if LAGY_X86_DISPATCH
+				{ Isa::Sse41, &Detail::lookupNibblesSse41 },
+				{ Isa::Avx2, &Detail::lookupNibblesAvx2 },
+				{ Isa::Avx512, &Detail::lookupNibblesAvx512 },
+#endif
+			};
+			return selectKernel(variants, isa);
+		}
+
+		/// <summary>
+		/// Looks up every value in [first, last) and writes the results to out.
+		/// 16 entry tables of single byte results over byte inputs are applied with pshufb, 16 to 64 values at a
+		/// time depending on the instruction set level selected at runtime, when the range and output are pointers.
+		/// </summary>
+		/// <param name="first"> The start of the input values. </param>
+		/// <param name="last"> The end of the input values. </param>
+		/// <param name="out"> The start of the output. </param>
+		/// <return> The end of the output. </return>
+		template <class InputIterator, class OutputIterator>
+		OutputIterator apply(InputIterator first, InputIterator last, OutputIterator out) const
+		{
+			if constexpr (SupportsShuffle_v<InputIterator, OutputIterator>)
+			{
+				static Kernel* const kernel = kernelFor(activeIsa());
+				kernel(reinterpret_cast<const std::uint8_t*>(m_table.data()), reinterpret_cast<const std::uint8_t*>(first),
+					reinterpret_cast<const std::uint8_t*>(last), reinterpret_cast<std::uint8_t*>(out));
+				return out + (last - first);
+			}
+			else
+			{
+				for (; first != last; ++first, ++out)
+				{
+					*out = (*this)[static_cast<Domain>(*first)];
+				}
+				return out;
+			}
+		}
+
+	private:
+
+		template <class InputIterator, class OutputIterator>
+		static constexpr bool SupportsShuffle_v =
+			size == 16 &&
+			sizeof(Domain) == 1 &&
+			sizeof(Result) == 1 &&
+			std::is_trivially_copyable_v<Result> &&
+			std::is_pointer_v<InputIterator> &&
+			std::is_pointer_v<OutputIterator> &&
+			sizeof(*std::declval<InputIterator>()) == 1 &&
+			std::is_same_v<std::remove_cv_t<std::remove_pointer_t<OutputIterator>>, Result>;
+
+		std::array<Result, size> m_table;
+	};
+
+	/// <summary>
+	/// Builds a LookupTable over Domain, deducing the result type from the function.
+	/// </summary>
+	/// <param name="function"> function mapping a domain value to its result. </param>
+	/// <return> A table holding the result of the function for every value of the domain. </return>
+	template <class Domain, std::size_t DomainBits = sizeof(Domain) * CHAR_BIT, class Function>
+	[[nodiscard]]
+	constexpr auto tabulate(Function function)
+	{
+		using Result = std::decay_t<std::invoke_result_t<Function&, Domain>>;
+		return LookupTable<Domain, Result, DomainBits>(std::move(function));
+	}
+}
\ No newline at end of file
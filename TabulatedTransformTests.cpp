@@ -0,0 +1,120 @@
+﻿#include "catch2/catch.hpp"
+#include "TabulatedTransform.h"
+#include "TransformIterator.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <string>
+#include <vector>
+
+namespace
+{
+	constexpr bool isDigit(std::uint8_t c)
+	{
+		return c >= '0' && c <= '9';
+	}
+
+	constexpr char hexDigit(std::uint8_t nibble)
+	{
+		return "0123456789abcdef"[nibble];
+	}
+}
+
+TEST_CASE("LookupTable tabulates a transform over a small domain", "[TabulatedTransform]")
+{
+	SECTION("LookupTable can be built at compile time from a constexpr function")
+	{
+		constexpr lagy::LookupTable<std::uint8_t, bool> digits(isDigit);
+		static_assert(digits['7']);
+		static_assert(!digits['x']);
+		REQUIRE(digits.size == 256);
+	}
+
+	SECTION("LookupTable agrees with the tabulated function for every domain value")
+	{
+		auto square = lagy::tabulate<std::uint16_t>([](std::uint16_t value) { return std::uint32_t{ value } * value; });
+		for (std::uint32_t value = 0; value <= 0xFFFF; ++value)
+		{
+			REQUIRE(square[static_cast<std::uint16_t>(value)] == value * value);
+		}
+	}
+
+	SECTION("LookupTable handles signed domains")
+	{
+		auto negate = lagy::tabulate<std::int8_t>([](std::int8_t value) { return -int{ value }; });
+		REQUIRE(negate[-128] == 128);
+		REQUIRE(negate[-1] == 1);
+		REQUIRE(negate[127] == -127);
+	}
+
+	SECTION("LookupTable works as the transform of a TransformIterator")
+	{
+		std::string text = "a1b22c333";
+		const auto digits = lagy::tabulate<std::uint8_t>(isDigit);
+
+		lagy::TransformIterator begin(text.begin(), std::cref(digits));
+		lagy::TransformIterator end(text.end(), std::cref(digits));
+		REQUIRE(std::count(begin, end, true) == 6);
+
+		// lookups return references into the table so random access is preserved
+		REQUIRE(std::is_same_v<decltype(begin)::iterator_category, std::random_access_iterator_tag>);
+		REQUIRE(begin[1]);
+		REQUIRE(!*(begin + 2));
+	}
+
+	SECTION("LookupTable bulk application matches element-wise lookup")
+	{
+		constexpr auto hex = lagy::tabulate<std::uint8_t, 4>(hexDigit);
+		std::vector<std::uint8_t> input;
+		for (int i = 0; i < 100; ++i)
+		{
+			input.push_back(static_cast<std::uint8_t>(i * 37));
+		}
+
+		std::vector<char> output(input.size());
+		char* outEnd = hex.apply(input.data(), input.data() + input.size(), output.data());
+		REQUIRE(outEnd == output.data() + output.size());
+		for (std::size_t i = 0; i < input.size(); ++i)
+		{
+			REQUIRE(output[i] == hexDigit(input[i] & 0x0F));
+		}
+
+		std::vector<char> iteratorOutput;
+		hex.apply(input.begin(), input.end(), std::back_inserter(iteratorOutput));
+		REQUIRE(iteratorOutput == output);
+	}
+
+	SECTION("Every supported lookup kernel level matches the scalar kernel")
+	{
+		using Table = lagy::LookupTable<std::uint8_t, char, 4>;
+		const Table hex(hexDigit);
+		std::vector<std::uint8_t> input;
+		for (int i = 0; i < 1000; ++i)
+		{
+			input.push_back(static_cast<std::uint8_t>(i * 37));
+		}
+
+		auto run = [&](Table::Kernel* kernel)
+		{
+			std::vector<char> out(input.size());
+			kernel(reinterpret_cast<const std::uint8_t*>(&hex[0]), input.data(), input.data() + input.size(), reinterpret_cast<std::uint8_t*>(out.data()));
+			return out;
+		};
+
+		const std::vector<char> expected = run(Table::kernelFor(lagy::Isa::Scalar));
+		for (std::size_t i = 0; i < input.size(); ++i)
+		{
+			REQUIRE(expected[i] == hexDigit(input[i] & 0x0F));
+		}
+		for (lagy::Isa isa : { lagy::Isa::Sse41, lagy::Isa::Avx2, lagy::Isa::Avx512 })
+		{
+			if (isa <= lagy::detectIsa())
+			{
+				INFO(lagy::isaName(isa));
+				REQUIRE(run(Table::kernelFor(isa)) == expected);
+			}
+		}
+	}
+}
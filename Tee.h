@@ -0,0 +1,31 @@
+﻿#pragma once
+
+#include <functional>
+#include <tuple>
+#include <utility>
+
+namespace lagy {
+
+	/// <summary>
+	/// Dereferences every iterator of [first, last) once and passes the result to each consumer in turn.
+	/// The consumers are a compile-time list, so all of them are inlined into a single loop body and one
+	/// evaluation of a TransformIterator's transform feeds every aggregate computed over the range.
+	///
+	/// Consumers are called with a const reference to the value and are taken by value; pass std::ref
+	/// to accumulate into a consumer owned by the caller.
+	/// </summary>
+	/// <param name="first"> The start of the range. </param>
+	/// <param name="last"> The end of the range. </param>
+	/// <param name="consumers"> Callables invoked with each value, in the order given. </param>
+	/// <return> The consumers after every value has been passed to them. </return>
+	template <class InputIterator, class... Consumers>
+	std::tuple<Consumers...> tee(InputIterator first, InputIterator last, Consumers... consumers)
+	{
+		for (; first != last; ++first)
+		{
+			const auto& value = *first;
+			(std::invoke(consumers, value), ...);
+		}
+		return std::tuple<Consumers...>(std::move(consumers)...);
+	}
+}
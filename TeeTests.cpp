@@ -0,0 +1,69 @@
+﻿#include "catch2/catch.hpp"
+#include "Tee.h"
+#include "TransformIterator.h"
+
+#include <algorithm>
+#include <functional>
+#include <limits>
+#include <map>
+#include <vector>
+
+TEST_CASE("tee evaluates each transformed element once for every consumer", "[Tee]")
+{
+	std::vector<int> container = { 4, -2, 9, 4, 7 };
+	int evaluations = 0;
+	auto square = [&evaluations](const std::vector<int>::iterator& it)
+	{
+		++evaluations;
+		return *it * *it;
+	};
+	lagy::TransformIterator begin(container.begin(), square);
+	lagy::TransformIterator end(container.end(), square);
+
+	SECTION("Consumers are returned with their accumulated state")
+	{
+		struct Sum
+		{
+			int total = 0;
+			void operator()(int value) { total += value; }
+		};
+		struct Max
+		{
+			int largest = std::numeric_limits<int>::min();
+			void operator()(int value) { largest = std::max(largest, value); }
+		};
+
+		auto [sum, max] = lagy::tee(begin, end, Sum{}, Max{});
+		REQUIRE(sum.total == 16 + 4 + 81 + 16 + 49);
+		REQUIRE(max.largest == 81);
+		REQUIRE(evaluations == 5);
+	}
+
+	SECTION("Consumers held by the caller can be passed by reference")
+	{
+		struct Count
+		{
+			int count = 0;
+			void operator()(int) { ++count; }
+		};
+
+		std::map<int, int> histogram;
+		Count count;
+		lagy::tee(begin, end, [&histogram](int value) { ++histogram[value]; }, std::ref(count));
+		REQUIRE(histogram.at(16) == 2);
+		REQUIRE(count.count == 5);
+		REQUIRE(evaluations == 5);
+	}
+
+	SECTION("Consumers see the elements in order")
+	{
+		std::vector<int> first;
+		std::vector<int> second;
+		lagy::tee(begin, end,
+			[&first](int value) { first.push_back(value); },
+			[&second](int value) { second.push_back(value); });
+		REQUIRE(first == std::vector<int>{ 16, 4, 81, 16, 49 });
+		REQUIRE(second == first);
+		REQUIRE(evaluations == 5);
+	}
+}
@@ -0,0 +1,318 @@
+﻿#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <string_view>
+#include <utility>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+namespace lagy {
+
+	/// <summary>
+	/// A set of delimiter bytes with a fast search for the first delimiter in a text.
+	///
+	/// A single delimiter is searched with memchr. Sets of up to vectorDelimiters bytes compare 32 bytes at a time
+	/// with AVX2 or 16 with SSE2 when compiled for them, combining one comparison per delimiter into a bitmask.
+	/// Larger sets, and the tail of the text, are tested byte by byte against a 256 bit membership table.
+	/// </summary>
+	class DelimiterSet
+	{
+	public:
+
+		/// <summary>
+		/// The largest set searched with vector comparisons.
+		/// </summary>
+		static constexpr std::size_t vectorDelimiters = 8;
+
+		/// <summary>
+		/// Constructor:
+		/// Creates a set of the distinct bytes of a string.
+		/// </summary>
+		/// <param name="delimiters"> The delimiter bytes. </param>
+		DelimiterSet(std::string_view delimiters)
+		{
+			for (char delimiter : delimiters)
+			{
+				const auto byte = static_cast<unsigned char>(delimiter);
+				if (!contains(delimiter))
+				{
+					m_members[byte / 64] |= std::uint64_t{ 1 } << (byte % 64);
+					if (m_count < vectorDelimiters)
+					{
+						m_delimiters[m_count] = delimiter;
+					}
+					++m_count;
+				}
+			}
+		}
+
+		/// <summary>
+		/// Constructor:
+		/// Creates a set of the distinct bytes of a null-terminated string.
+		/// </summary>
+		DelimiterSet(const char* delimiters) :
+			DelimiterSet(std::string_view(delimiters))
+		{
+		}
+
+		/// <summary>
+		/// Constructor:
+		/// Creates a set of a single delimiter.
+		/// </summary>
+		DelimiterSet(char delimiter) :
+			DelimiterSet(std::string_view(&delimiter, 1))
+		{
+		}
+
+		/// <summary>
+		/// Gets the number of distinct delimiters.
+		/// </summary>
+		[[nodiscard]]
+		std::size_t size() const
+		{
+			return m_count;
+		}
+
+		/// <summary>
+		/// Checks whether a byte is a delimiter.
+		/// </summary>
+		[[nodiscard]]
+		bool contains(char c) const
+		{
+			const auto byte = static_cast<unsigned char>(c);
+			return (m_members[byte / 64] >> (byte % 64)) & 1;
+		}
+
+		/// <summary>
+		/// Finds the first delimiter in a text at or after a position.
+		/// </summary>
+		/// <param name="text"> The text. </param>
+		/// <param name="from"> The position to start at. </param>
+		/// <return> The position of the delimiter, or text.size() if there is none. </return>
+		[[nodiscard]]
+		std::size_t find(std::string_view text, std::size_t from) const
+		{
+			const char* data = text.data();
+			const std::size_t size = text.size();
+			std::size_t i = from;
+
+			if (m_count == 1)
+			{
+				const void* found = i < size ? std::memchr(data + i, m_delimiters[0], size - i) : nullptr;
+				return found == nullptr ? size : static_cast<std::size_t>(static_cast<const char*>(found) - data);
+			}
+
+			if (m_count <= vectorDelimiters)
+			{
+#if defined(__AVX2__)
+				for (; i + 32 <= size; i += 32)
+				{
+					const __m256i bytes = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+					__m256i matches = _mm256_setzero_si256();
+					for (std::size_t d = 0; d < m_count; ++d)
+					{
+						matches = _mm256_or_si256(matches, _mm256_cmpeq_epi8(bytes, _mm256_set1_epi8(m_delimiters[d])));
+					}
+					if (const auto mask = static_cast<std::uint32_t>(_mm256_movemask_epi8(matches)); mask != 0)
+					{
+						return i + static_cast<std::size_t>(__builtin_ctz(mask));
+					}
+				}
+#endif
+#if defined(__SSE2__)
+				for (; i + 16 <= size; i += 16)
+				{
+					const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+					__m128i matches = _mm_setzero_si128();
+					for (std::size_t d = 0; d < m_count; ++d)
+					{
+						matches = _mm_or_si128(matches, _mm_cmpeq_epi8(bytes, _mm_set1_epi8(m_delimiters[d])));
+					}
+					if (const auto mask = static_cast<std::uint32_t>(_mm_movemask_epi8(matches)); mask != 0)
+					{
+						return i + static_cast<std::size_t>(__builtin_ctz(mask));
+					}
+				}
+#endif
+			}
+
+			for (; i < size; ++i)
+			{
+				if (contains(data[i]))
+				{
+					return i;
+				}
+			}
+			return size;
+		}
+
+	private:
+		std::array<std::uint64_t, 4> m_members{};
+		std::array<char, vectorDelimiters> m_delimiters{};
+		std::size_t m_count = 0;
+	};
+
+	/// <summary>
+	/// A forward iterator over the fields of a text separated by delimiters, yielding views into the text without
+	/// copying, usable as the wrapped iterator of a field-parsing TransformIterator.
+	///
+	/// A text with n delimiters has n + 1 fields, some of which may be empty; with skipEmpty, empty fields are
+	/// not yielded. Different delimiter sets split the same text at different levels, for example records on
+	/// newlines and then fields on commas.
+	/// </summary>
+	class TokenIterator
+	{
+	public:
+
+		// std::iterator_traits types
+		using value_type = std::string_view;
+		using difference_type = std::ptrdiff_t;
+		using pointer = const std::string_view*;
+		using reference = const std::string_view&;
+		using iterator_category = std::forward_iterator_tag;
+
+		TokenIterator() = default;
+
+		/// <summary>
+		/// Constructor:
+		/// Creates an iterator at the first field of a text.
+		/// </summary>
+		/// <param name="text"> The text. Must outlive the iterator and the fields. </param>
+		/// <param name="delimiters"> The bytes separating fields. </param>
+		/// <param name="skipEmpty"> Whether empty fields are skipped. </param>
+		TokenIterator(std::string_view text, DelimiterSet delimiters, bool skipEmpty = false) :
+			m_text(text),
+			m_delimiters(std::move(delimiters)),
+			m_skipEmpty(skipEmpty)
+		{
+			seek(0);
+		}
+
+		/// <summary>
+		/// Gets the position of the current field in the text.
+		/// </summary>
+		[[nodiscard]]
+		std::size_t offset() const
+		{
+			return m_fieldBegin;
+		}
+
+		/// <summary>
+		/// Gets the current field.
+		/// </summary>
+		[[nodiscard]]
+		reference operator*() const
+		{
+			return m_field;
+		}
+
+		/// <summary>
+		/// Gets the current field.
+		/// </summary>
+		[[nodiscard]]
+		pointer operator->() const
+		{
+			return &m_field;
+		}
+
+		/// <summary>
+		/// Moves to the next field.
+		/// </summary>
+		TokenIterator& operator++()
+		{
+			const std::size_t fieldEnd = m_fieldBegin + m_field.size();
+			if (fieldEnd == m_text.size())
+			{
+				m_fieldBegin = atEnd;
+				m_field = std::string_view();
+			}
+			else
+			{
+				seek(fieldEnd + 1);
+			}
+			return *this;
+		}
+
+		/// <summary>
+		/// Moves to the next field.
+		/// Returns an iterator at the original field.
+		/// </summary>
+		[[nodiscard]]
+		TokenIterator operator++(int)
+		{
+			TokenIterator out(*this);
+			++(*this);
+			return out;
+		}
+
+		/// <summary>
+		/// Compare iterators for equality of field position.
+		/// </summary>
+		[[nodiscard]]
+		friend bool operator==(const TokenIterator& lhs, const TokenIterator& rhs)
+		{
+			return lhs.m_fieldBegin == rhs.m_fieldBegin;
+		}
+
+		/// <summary>
+		/// Compare iterators for inequality of field position.
+		/// </summary>
+		[[nodiscard]]
+		friend bool operator!=(const TokenIterator& lhs, const TokenIterator& rhs)
+		{
+			return lhs.m_fieldBegin != rhs.m_fieldBegin;
+		}
+
+	private:
+		static constexpr std::size_t atEnd = static_cast<std::size_t>(-1);
+
+		void seek(std::size_t position)
+		{
+			while (true)
+			{
+				const std::size_t fieldEnd = m_delimiters.find(m_text, position);
+				if (!m_skipEmpty || fieldEnd != position)
+				{
+					m_fieldBegin = position;
+					m_field = m_text.substr(position, fieldEnd - position);
+					return;
+				}
+				if (fieldEnd == m_text.size())
+				{
+					m_fieldBegin = atEnd;
+					m_field = std::string_view();
+					return;
+				}
+				position = fieldEnd + 1;
+			}
+		}
+
+		std::string_view m_text;
+		DelimiterSet m_delimiters{ std::string_view() };
+		std::string_view m_field;
+		std::size_t m_fieldBegin = atEnd;
+		bool m_skipEmpty = false;
+	};
+
+	/// <summary>
+	/// Creates the begin and end iterators over the fields of a text.
+	/// </summary>
+	/// <param name="text"> The text. Must outlive the iterators and the fields. </param>
+	/// <param name="delimiters"> The bytes separating fields. </param>
+	/// <param name="skipEmpty"> Whether empty fields are skipped. </param>
+	/// <return> The first iterator and the end iterator. </return>
+	[[nodiscard]]
+	inline std::pair<TokenIterator, TokenIterator> tokenize(std::string_view text, DelimiterSet delimiters, bool skipEmpty = false)
+	{
+		return { TokenIterator(text, std::move(delimiters), skipEmpty), TokenIterator() };
+	}
+}
@@ -0,0 +1,70 @@
+﻿#include "catch2/catch.hpp"
+#include "TokenIterator.h"
+#include "TransformIterator.h"
+
+#include <charconv>
+#include <numeric>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace
+{
+	std::vector<std::string_view> fields(std::string_view text, lagy::DelimiterSet delimiters, bool skipEmpty = false)
+	{
+		auto [first, last] = lagy::tokenize(text, std::move(delimiters), skipEmpty);
+		return std::vector<std::string_view>(first, last);
+	}
+}
+
+TEST_CASE("DelimiterSet finds delimiters across vector block boundaries", "[TokenIterator]")
+{
+	std::string text(100, 'x');
+	for (std::size_t position : { 0, 15, 16, 31, 32, 47, 63, 64, 95, 99 })
+	{
+		std::string probe = text;
+		probe[position] = ';';
+		REQUIRE(lagy::DelimiterSet(';').find(probe, 0) == position);
+		REQUIRE(lagy::DelimiterSet(",;\t").find(probe, 0) == position);
+		REQUIRE(lagy::DelimiterSet("0123456789;").find(probe, 0) == position);
+	}
+	REQUIRE(lagy::DelimiterSet(",;").find(text, 0) == text.size());
+	REQUIRE(lagy::DelimiterSet(",;").find(text, text.size()) == text.size());
+	REQUIRE(lagy::DelimiterSet(",,;;").size() == 2);
+}
+
+TEST_CASE("TokenIterator splits text into field views", "[TokenIterator]")
+{
+	REQUIRE(fields("a,b,,c", ',') == std::vector<std::string_view>{ "a", "b", "", "c" });
+	REQUIRE(fields("a,b,", ',') == std::vector<std::string_view>{ "a", "b", "" });
+	REQUIRE(fields("", ',') == std::vector<std::string_view>{ "" });
+	REQUIRE(fields("  split \t on\twhitespace  ", " \t", true) == std::vector<std::string_view>{ "split", "on", "whitespace" });
+	REQUIRE(fields(" \t ", " \t", true).empty());
+
+	// fields are views into the text
+	const std::string text = "key=value";
+	auto [first, last] = lagy::tokenize(text, '=');
+	REQUIRE(first->data() == text.data());
+	REQUIRE((++first).offset() == 4);
+}
+
+TEST_CASE("TokenIterator feeds field-parsing transforms at several levels", "[TokenIterator]")
+{
+	const std::string csv = "1,2,3\n40,50\n\n600\n";
+
+	auto parse = [](const lagy::TokenIterator& it)
+	{
+		int value = 0;
+		std::from_chars(it->data(), it->data() + it->size(), value);
+		return value;
+	};
+
+	std::vector<int> rowSums;
+	auto [row, rowsEnd] = lagy::tokenize(csv, "\r\n", true);
+	for (; row != rowsEnd; ++row)
+	{
+		auto [field, fieldsEnd] = lagy::tokenize(*row, ',');
+		rowSums.push_back(std::accumulate(lagy::TransformIterator(field, parse), lagy::TransformIterator(fieldsEnd, parse), 0));
+	}
+	REQUIRE(rowSums == std::vector<int>{ 6, 90, 600 });
+}
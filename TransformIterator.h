@@ -1,5 +1,6 @@
 ﻿#pragma once
 
+#include <functional>
 #include <type_traits>
 #include <iterator>
 
@@ -125,7 +126,7 @@ namespace lagy {
 			/// <return> A new iterator at the position of the original before it was moved backward. </return>
 			CrtpChildIterator& operator--()
 			{
-				--getCrtpThis->getWrappedIterator();
+				--getCrtpThis()->getWrappedIterator();
 				return *getCrtpThis();
 			}
 
@@ -137,7 +138,7 @@ namespace lagy {
 			[[nodiscard]]
 			CrtpChildIterator operator--(int)
 			{
-				CrtpChildIterator out(*this);
+				CrtpChildIterator out(*getCrtpThis());
 				--(*getCrtpThis());
 				return out;
 			}
@@ -189,7 +190,7 @@ namespace lagy {
 			CrtpChildIterator& operator+=(difference_type n)
 			{
 				getCrtpThis()->getWrappedIterator() += n;
-				return *this;
+				return *getCrtpThis();
 			}
 
 			/// <summary>
@@ -201,7 +202,7 @@ namespace lagy {
 			CrtpChildIterator& operator-=(difference_type n)
 			{
 				getCrtpThis()->getWrappedIterator() -= n;
-				return *this;
+				return *getCrtpThis();
 			}
 
 			/// <summary>
@@ -215,7 +216,7 @@ namespace lagy {
 			{
 				WrappedIterator tempIt = getCrtpThis()->getWrappedIterator();
 				tempIt += n;
-				return CrtpChildIterator(tempIt, m_transform);
+				return CrtpChildIterator(tempIt, getCrtpThis()->getTransform());
 			}
 
 			/// <summary>
@@ -242,7 +243,20 @@ namespace lagy {
 			{
 				WrappedIterator tempIt = getCrtpThis()->getWrappedIterator();
 				tempIt -= n;
-				return CrtpChildIterator(tempIt, m_transform);
+				return CrtpChildIterator(tempIt, getCrtpThis()->getTransform());
+			}
+
+			/// <summary>
+			/// Returns the number of steps from rhs to lhs.
+			/// Only available if the wrapped iterator is a random access iterator.
+			/// </summary>
+			/// <param name="lhs"> The end point. </return>
+			/// <param name="rhs"> The starting point. </return>
+			/// <return> The distance between the wrapped iterators. </return>
+			[[nodiscard]]
+			friend difference_type operator-(const CrtpChildIterator& lhs, const CrtpChildIterator& rhs)
+			{
+				return lhs.getWrappedIterator() - rhs.getWrappedIterator();
 			}
 
 			/// <summary>
@@ -269,6 +283,12 @@ namespace lagy {
 			{
 				return static_cast<CrtpChildIterator*>(this);
 			}
+
+			[[nodiscard]]
+			const CrtpChildIterator* getCrtpThis() const
+			{
+				return static_cast<const CrtpChildIterator*>(this);
+			}
 		};
 	}
 
@@ -327,6 +347,26 @@ namespace lagy {
 			return m_wrappedIt;
 		}
 
+		/// <summary>
+		/// Gets the iterator wrapped by this transform iterator
+		/// </summary>
+		/// <return> The iterator wrapped by this transform iterator. </return>
+		[[nodiscard]]
+		const WrappedIteratorType& getWrappedIterator() const
+		{
+			return m_wrappedIt;
+		}
+
+		/// <summary>
+		/// Gets the transform applied by this transform iterator
+		/// </summary>
+		/// <return> The unary operation applied whenever this iterator is dereferenced. </return>
+		[[nodiscard]]
+		const UnaryOperation& getTransform() const
+		{
+			return m_transform;
+		}
+
 		/// <summary>
 		/// Apply the transform to the wrapped iterator and return the result
 		/// </summary>
@@ -0,0 +1,363 @@
+﻿#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <string_view>
+#include <utility>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+namespace lagy {
+
+	/// <summary>
+	/// The code point yielded in place of an invalid UTF-8 sequence.
+	/// </summary>
+	inline constexpr char32_t replacementCharacter = U'\uFFFD';
+
+	namespace Detail
+	{
+		/// <summary>
+		/// A decoded code point and the number of bytes it was decoded from.
+		/// </summary>
+		struct Utf8Decoded
+		{
+			char32_t codePoint;
+			std::size_t length;
+		};
+
+		/// <summary>
+		/// Decodes the UTF-8 sequence at the start of [p, end), which must not be empty.
+		/// An invalid sequence decodes to the replacement character and covers its longest valid prefix,
+		/// or the first byte if there is none, as recommended by the Unicode standard.
+		/// </summary>
+		[[nodiscard]]
+		inline Utf8Decoded decodeUtf8(const unsigned char* p, const unsigned char* end)
+		{
+			const unsigned char lead = p[0];
+			if (lead < 0x80)
+			{
+				return { lead, 1 };
+			}
+
+			// the length and the valid range of the second byte, from Table 3-7 of the Unicode standard
+			std::size_t length;
+			unsigned char low = 0x80;
+			unsigned char high = 0xBF;
+			char32_t codePoint;
+			if (lead >= 0xC2 && lead <= 0xDF)
+			{
+				length = 2;
+				codePoint = lead & 0x1F;
+			}
+			else if (lead >= 0xE0 && lead <= 0xEF)
+			{
+				length = 3;
+				codePoint = lead & 0x0F;
+				low = lead == 0xE0 ? 0xA0 : 0x80;
+				high = lead == 0xED ? 0x9F : 0xBF;
+			}
+			else if (lead >= 0xF0 && lead <= 0xF4)
+			{
+				length = 4;
+				codePoint = lead & 0x07;
+				low = lead == 0xF0 ? 0x90 : 0x80;
+				high = lead == 0xF4 ? 0x8F : 0xBF;
+			}
+			else
+			{
+				return { replacementCharacter, 1 };
+			}
+
+			for (std::size_t i = 1; i < length; ++i)
+			{
+				if (p + i == end || p[i] < low || p[i] > high)
+				{
+					return { replacementCharacter, i };
+				}
+				codePoint = (codePoint << 6) | (p[i] & 0x3F);
+				low = 0x80;
+				high = 0xBF;
+			}
+			return { codePoint, length };
+		}
+
+		/// <summary>
+		/// Counts the ASCII bytes at the start of [p, end), testing 32 bytes at a time with AVX2 or 16 with SSE2.
+		/// </summary>
+		[[nodiscard]]
+		inline std::size_t asciiPrefixLength(const unsigned char* p, const unsigned char* end)
+		{
+			const unsigned char* start = p;
+#if defined(__AVX2__)
+			for (; end - p >= 32; p += 32)
+			{
+				const auto mask = static_cast<std::uint32_t>(_mm256_movemask_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(p))));
+				if (mask != 0)
+				{
+					return static_cast<std::size_t>(p - start) + static_cast<std::size_t>(__builtin_ctz(mask));
+				}
+			}
+#endif
+#if defined(__SSE2__)
+			for (; end - p >= 16; p += 16)
+			{
+				const auto mask = static_cast<std::uint32_t>(_mm_movemask_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p))));
+				if (mask != 0)
+				{
+					return static_cast<std::size_t>(p - start) + static_cast<std::size_t>(__builtin_ctz(mask));
+				}
+			}
+#endif
+			for (; p != end && *p < 0x80; ++p)
+			{
+			}
+			return static_cast<std::size_t>(p - start);
+		}
+
+		/// <summary>
+		/// Calls emit(codePoint) for every code point of a UTF-8 text, copying runs of ASCII with emitAscii(first, count).
+		/// </summary>
+		template <class AsciiEmitter, class CodePointEmitter>
+		void forEachUtf8Run(std::string_view text, AsciiEmitter&& emitAscii, CodePointEmitter&& emit)
+		{
+			auto p = reinterpret_cast<const unsigned char*>(text.data());
+			const auto end = p + text.size();
+			while (p != end)
+			{
+				const std::size_t ascii = asciiPrefixLength(p, end);
+				emitAscii(p, ascii);
+				p += ascii;
+				if (p != end)
+				{
+					const Utf8Decoded decoded = decodeUtf8(p, end);
+					emit(decoded.codePoint);
+					p += decoded.length;
+				}
+			}
+		}
+	}
+
+	/// <summary>
+	/// A bidirectional iterator decoding the code points of UTF-8 text, usable as the wrapped iterator of a
+	/// TransformIterator over code points. Invalid sequences are yielded as U+FFFD, one per maximal invalid
+	/// subpart, in the same positions whichever direction the text is walked in.
+	/// </summary>
+	class Utf8Iterator
+	{
+	public:
+
+		// std::iterator_traits types
+		using value_type = char32_t;
+		using difference_type = std::ptrdiff_t;
+		using pointer = const char32_t*;
+		using reference = const char32_t&;
+		using iterator_category = std::bidirectional_iterator_tag;
+
+		Utf8Iterator() = default;
+
+		/// <summary>
+		/// Constructor:
+		/// Creates an iterator at a byte offset of a text, which must be the start of a code point or the end.
+		/// </summary>
+		/// <param name="text"> The text. Must outlive the iterator. </param>
+		/// <param name="offset"> The byte offset. </param>
+		explicit Utf8Iterator(std::string_view text, std::size_t offset = 0) :
+			m_first(reinterpret_cast<const unsigned char*>(text.data())),
+			m_last(m_first + text.size()),
+			m_current(m_first + offset)
+		{
+			decode();
+		}
+
+		/// <summary>
+		/// Gets the byte offset of the current code point in the text.
+		/// </summary>
+		[[nodiscard]]
+		std::size_t offset() const
+		{
+			return static_cast<std::size_t>(m_current - m_first);
+		}
+
+		/// <summary>
+		/// Gets the number of bytes the current code point was decoded from.
+		/// </summary>
+		[[nodiscard]]
+		std::size_t length() const
+		{
+			return m_decoded.length;
+		}
+
+		/// <summary>
+		/// Gets the current code point.
+		/// </summary>
+		[[nodiscard]]
+		reference operator*() const
+		{
+			return m_decoded.codePoint;
+		}
+
+		/// <summary>
+		/// Moves to the next code point.
+		/// </summary>
+		Utf8Iterator& operator++()
+		{
+			m_current += m_decoded.length;
+			decode();
+			return *this;
+		}
+
+		/// <summary>
+		/// Moves to the next code point.
+		/// Returns an iterator at the original code point.
+		/// </summary>
+		[[nodiscard]]
+		Utf8Iterator operator++(int)
+		{
+			Utf8Iterator out(*this);
+			++(*this);
+			return out;
+		}
+
+		/// <summary>
+		/// Moves to the previous code point.
+		/// </summary>
+		Utf8Iterator& operator--()
+		{
+			// step back to the nearest possible lead byte; if the sequence there does not end here, the previous
+			// byte is an invalid sequence of its own
+			const unsigned char* candidate = m_current - 1;
+			while (candidate != m_first && m_current - candidate < 4 && (*candidate & 0xC0) == 0x80)
+			{
+				--candidate;
+			}
+			const Detail::Utf8Decoded decoded = Detail::decodeUtf8(candidate, m_last);
+			if (candidate + decoded.length == m_current)
+			{
+				m_current = candidate;
+				m_decoded = decoded;
+			}
+			else
+			{
+				--m_current;
+				decode();
+			}
+			return *this;
+		}
+
+		/// <summary>
+		/// Moves to the previous code point.
+		/// Returns an iterator at the original code point.
+		/// </summary>
+		[[nodiscard]]
+		Utf8Iterator operator--(int)
+		{
+			Utf8Iterator out(*this);
+			--(*this);
+			return out;
+		}
+
+		/// <summary>
+		/// Compare iterators for equality of position.
+		/// </summary>
+		[[nodiscard]]
+		friend bool operator==(const Utf8Iterator& lhs, const Utf8Iterator& rhs)
+		{
+			return lhs.m_current == rhs.m_current;
+		}
+
+		/// <summary>
+		/// Compare iterators for inequality of position.
+		/// </summary>
+		[[nodiscard]]
+		friend bool operator!=(const Utf8Iterator& lhs, const Utf8Iterator& rhs)
+		{
+			return lhs.m_current != rhs.m_current;
+		}
+
+	private:
+
+		void decode()
+		{
+			m_decoded = m_current == m_last ? Detail::Utf8Decoded{ 0, 0 } : Detail::decodeUtf8(m_current, m_last);
+		}
+
+		const unsigned char* m_first = nullptr;
+		const unsigned char* m_last = nullptr;
+		const unsigned char* m_current = nullptr;
+		Detail::Utf8Decoded m_decoded{ 0, 0 };
+	};
+
+	/// <summary>
+	/// Creates the begin and end iterators over the code points of a UTF-8 text.
+	/// </summary>
+	/// <param name="text"> The text. Must outlive the iterators. </param>
+	/// <return> The first iterator and the end iterator. </return>
+	[[nodiscard]]
+	inline std::pair<Utf8Iterator, Utf8Iterator> codePoints(std::string_view text)
+	{
+		return { Utf8Iterator(text), Utf8Iterator(text, text.size()) };
+	}
+
+	/// <summary>
+	/// Decodes a UTF-8 text to UTF-32, replacing invalid sequences with U+FFFD.
+	/// Runs of ASCII are found a vector at a time and widened without decoding.
+	/// </summary>
+	/// <param name="text"> The text. </param>
+	/// <param name="out"> The output, with room for at least text.size() code points. </param>
+	/// <return> The end of the output. </return>
+	inline char32_t* transcodeToUtf32(std::string_view text, char32_t* out)
+	{
+		Detail::forEachUtf8Run(text,
+			[&out](const unsigned char* ascii, std::size_t count)
+			{
+				for (std::size_t i = 0; i < count; ++i)
+				{
+					out[i] = ascii[i];
+				}
+				out += count;
+			},
+			[&out](char32_t codePoint) { *out++ = codePoint; });
+		return out;
+	}
+
+	/// <summary>
+	/// Decodes a UTF-8 text to UTF-16, replacing invalid sequences with U+FFFD and writing code points beyond
+	/// the basic multilingual plane as surrogate pairs. Runs of ASCII are found a vector at a time and widened
+	/// without decoding.
+	/// </summary>
+	/// <param name="text"> The text. </param>
+	/// <param name="out"> The output, with room for at least text.size() code units. </param>
+	/// <return> The end of the output. </return>
+	inline char16_t* transcodeToUtf16(std::string_view text, char16_t* out)
+	{
+		Detail::forEachUtf8Run(text,
+			[&out](const unsigned char* ascii, std::size_t count)
+			{
+				for (std::size_t i = 0; i < count; ++i)
+				{
+					out[i] = ascii[i];
+				}
+				out += count;
+			},
+			[&out](char32_t codePoint)
+			{
+				if (codePoint < 0x10000)
+				{
+					*out++ = static_cast<char16_t>(codePoint);
+				}
+				else
+				{
+					codePoint -= 0x10000;
+					*out++ = static_cast<char16_t>(0xD800 + (codePoint >> 10));
+					*out++ = static_cast<char16_t>(0xDC00 + (codePoint & 0x3FF));
+				}
+			});
+		return out;
+	}
+}
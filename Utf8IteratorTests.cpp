@@ -0,0 +1,83 @@
+﻿#include "catch2/catch.hpp"
+#include "TransformIterator.h"
+#include "Utf8Iterator.h"
+
+#include <algorithm>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace
+{
+	std::u32string forward(std::string_view text)
+	{
+		auto [first, last] = lagy::codePoints(text);
+		return std::u32string(first, last);
+	}
+
+	std::u32string backward(std::string_view text)
+	{
+		auto [first, last] = lagy::codePoints(text);
+		std::u32string out;
+		while (last != first)
+		{
+			out.push_back(*--last);
+		}
+		std::reverse(out.begin(), out.end());
+		return out;
+	}
+}
+
+TEST_CASE("Utf8Iterator decodes code points in both directions", "[Utf8Iterator]")
+{
+	const std::string text = "a\xC3\xA9\xE2\x82\xAC\xF0\x9F\x98\x80z";
+	REQUIRE(forward(text) == U"aé€\U0001F600z");
+	REQUIRE(backward(text) == forward(text));
+
+	auto [first, last] = lagy::codePoints(text);
+	REQUIRE(std::distance(first, last) == 5);
+	REQUIRE((++++first).offset() == 3);
+	REQUIRE(first.length() == 3);
+
+	auto isAscii = [](const lagy::Utf8Iterator& it) { return *it < 0x80; };
+	REQUIRE(std::count_if(lagy::TransformIterator(first, isAscii), lagy::TransformIterator(last, isAscii), [](bool ascii) { return ascii; }) == 1);
+}
+
+TEST_CASE("Utf8Iterator replaces invalid sequences consistently", "[Utf8Iterator]")
+{
+	const std::vector<std::pair<std::string, std::u32string>> cases{
+		{ "\x80\x80", U"��" },
+		{ "\xE2\x82" "A", U"�A" },
+		{ "\xE2\x82\xE2\x82\xAC", U"�€" },
+		{ "\xE0\x80\x80", U"���" },
+		{ "\xED\xA0\x80", U"���" },
+		{ "\xF0\x90\x80\x80\x80", U"\U00010000�" },
+		{ "\xF4\x90\x80\x80", U"����" },
+		{ "\xC0\xAF", U"��" },
+		{ "x\xF0\x9F\x98", U"x�" },
+	};
+	for (const auto& [text, expected] : cases)
+	{
+		REQUIRE(forward(text) == expected);
+		REQUIRE(backward(text) == expected);
+	}
+}
+
+TEST_CASE("Bulk transcoding matches the iterator", "[Utf8Iterator]")
+{
+	std::string text;
+	for (int i = 0; i < 20; ++i)
+	{
+		text += "plain ascii text run, ";
+		text += "\xCE\xB1\xCE\xB2\xF0\x9F\x98\x80\xFF";
+	}
+
+	std::u32string utf32(text.size(), U'\0');
+	utf32.resize(static_cast<std::size_t>(lagy::transcodeToUtf32(text, utf32.data()) - utf32.data()));
+	REQUIRE(utf32 == forward(text));
+
+	std::u16string utf16(text.size(), u'\0');
+	utf16.resize(static_cast<std::size_t>(lagy::transcodeToUtf16(text, utf16.data()) - utf16.data()));
+	REQUIRE(utf16.size() == utf32.size() + 20);
+	REQUIRE(utf16.substr(22, 5) == u"αβ\U0001F600�");
+}